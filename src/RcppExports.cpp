@@ -10,36 +10,166 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// rcpp_osmdata_adiff
+Rcpp::List rcpp_osmdata_adiff(const std::string& st, const bool geometry);
+RcppExport SEXP _osmdata_rcpp_osmdata_adiff(SEXP stSEXP, SEXP geometrySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type st(stSEXP);
+    Rcpp::traits::input_parameter< const bool >::type geometry(geometrySEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_adiff(st, geometry));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_osmdata_arrow
+Rcpp::CharacterVector rcpp_osmdata_arrow(const std::string& st, const std::string& path, const bool merge_lines, const bool resolve_relations, const bool area_tags, const bool interleaved, const bool stream);
+RcppExport SEXP _osmdata_rcpp_osmdata_arrow(SEXP stSEXP, SEXP pathSEXP, SEXP merge_linesSEXP, SEXP resolve_relationsSEXP, SEXP area_tagsSEXP, SEXP interleavedSEXP, SEXP streamSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type st(stSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< const bool >::type merge_lines(merge_linesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type resolve_relations(resolve_relationsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type area_tags(area_tagsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type interleaved(interleavedSEXP);
+    Rcpp::traits::input_parameter< const bool >::type stream(streamSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_arrow(st, path, merge_lines, resolve_relations, area_tags, interleaved, stream));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_osmdata_csv
+Rcpp::List rcpp_osmdata_csv(const std::string& st, const bool header, const bool typed);
+RcppExport SEXP _osmdata_rcpp_osmdata_csv(SEXP stSEXP, SEXP headerSEXP, SEXP typedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type st(stSEXP);
+    Rcpp::traits::input_parameter< const bool >::type header(headerSEXP);
+    Rcpp::traits::input_parameter< const bool >::type typed(typedSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_csv(st, header, typed));
+    return rcpp_result_gen;
+END_RCPP
+}
 // rcpp_osmdata_df
-Rcpp::List rcpp_osmdata_df(const std::string& st);
-RcppExport SEXP _osmdata_rcpp_osmdata_df(SEXP stSEXP) {
+Rcpp::List rcpp_osmdata_df(const std::string& st, const int factor_levels, const bool typed, const Rcpp::NumericVector units);
+RcppExport SEXP _osmdata_rcpp_osmdata_df(SEXP stSEXP, SEXP factor_levelsSEXP, SEXP typedSEXP, SEXP unitsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type st(stSEXP);
+    Rcpp::traits::input_parameter< const int >::type factor_levels(factor_levelsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type typed(typedSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type units(unitsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_df(st, factor_levels, typed, units));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_osm_graph
+Rcpp::List rcpp_osm_graph(const std::string& st, const std::string& key, const std::vector <std::string>& values, const bool directed, const bool way_index, const bool lengths);
+RcppExport SEXP _osmdata_rcpp_osm_graph(SEXP stSEXP, SEXP keySEXP, SEXP valuesSEXP, SEXP directedSEXP, SEXP way_indexSEXP, SEXP lengthsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const std::string& >::type st(stSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_df(st));
+    Rcpp::traits::input_parameter< const std::string& >::type key(keySEXP);
+    Rcpp::traits::input_parameter< const std::vector <std::string>& >::type values(valuesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type directed(directedSEXP);
+    Rcpp::traits::input_parameter< const bool >::type way_index(way_indexSEXP);
+    Rcpp::traits::input_parameter< const bool >::type lengths(lengthsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_osm_graph(st, key, values, directed, way_index, lengths));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_sc_c
+Rcpp::List rcpp_sc_c(const Rcpp::List x, const Rcpp::CharacterVector tables);
+RcppExport SEXP _osmdata_rcpp_sc_c(SEXP xSEXP, SEXP tablesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::CharacterVector >::type tables(tablesSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_sc_c(x, tables));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_sc_trim
+Rcpp::List rcpp_sc_trim(const Rcpp::NumericVector x, const Rcpp::NumericVector y, const Rcpp::NumericMatrix poly, const Rcpp::List index, const int n_objects, const int n_relations, const bool exclude);
+RcppExport SEXP _osmdata_rcpp_sc_trim(SEXP xSEXP, SEXP ySEXP, SEXP polySEXP, SEXP indexSEXP, SEXP n_objectsSEXP, SEXP n_relationsSEXP, SEXP excludeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type poly(polySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List >::type index(indexSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_objects(n_objectsSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_relations(n_relationsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type exclude(excludeSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_sc_trim(x, y, poly, index, n_objects, n_relations, exclude));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_sc_contract
+Rcpp::List rcpp_sc_contract(const Rcpp::IntegerVector v0, const Rcpp::IntegerVector v1, const Rcpp::IntegerVector object, const int n_vertices, const Rcpp::NumericVector d);
+RcppExport SEXP _osmdata_rcpp_sc_contract(SEXP v0SEXP, SEXP v1SEXP, SEXP objectSEXP, SEXP n_verticesSEXP, SEXP dSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type v0(v0SEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type v1(v1SEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type object(objectSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_vertices(n_verticesSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type d(dSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_sc_contract(v0, v1, object, n_vertices, d));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_sc_elevation
+Rcpp::List rcpp_sc_elevation(const Rcpp::CharacterVector files, const Rcpp::NumericVector x, const Rcpp::NumericVector y, const Rcpp::IntegerVector v0, const Rcpp::IntegerVector v1);
+RcppExport SEXP _osmdata_rcpp_sc_elevation(SEXP filesSEXP, SEXP xSEXP, SEXP ySEXP, SEXP v0SEXP, SEXP v1SEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::CharacterVector >::type files(filesSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type v0(v0SEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type v1(v1SEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_sc_elevation(files, x, y, v0, v1));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_osmdata_sc
-Rcpp::List rcpp_osmdata_sc(const std::string& st);
-RcppExport SEXP _osmdata_rcpp_osmdata_sc(SEXP stSEXP) {
+Rcpp::List rcpp_osmdata_sc(const std::string& st, const std::string& id_type, const bool lengths);
+RcppExport SEXP _osmdata_rcpp_osmdata_sc(SEXP stSEXP, SEXP id_typeSEXP, SEXP lengthsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const std::string& >::type st(stSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_sc(st));
+    Rcpp::traits::input_parameter< const std::string& >::type id_type(id_typeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type lengths(lengthsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_sc(st, id_type, lengths));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_osmdata_sf
-Rcpp::List rcpp_osmdata_sf(const std::string& st);
-RcppExport SEXP _osmdata_rcpp_osmdata_sf(SEXP stSEXP) {
+Rcpp::List rcpp_osmdata_sf(const std::string& st, const bool merge_lines, const bool resolve_relations, const bool area_tags, const bool wkb, const int factor_levels, const bool typed, const Rcpp::NumericVector units, const std::string& id_type);
+RcppExport SEXP _osmdata_rcpp_osmdata_sf(SEXP stSEXP, SEXP merge_linesSEXP, SEXP resolve_relationsSEXP, SEXP area_tagsSEXP, SEXP wkbSEXP, SEXP factor_levelsSEXP, SEXP typedSEXP, SEXP unitsSEXP, SEXP id_typeSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const std::string& >::type st(stSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_sf(st));
+    Rcpp::traits::input_parameter< const bool >::type merge_lines(merge_linesSEXP);
+    Rcpp::traits::input_parameter< const bool >::type resolve_relations(resolve_relationsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type area_tags(area_tagsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type wkb(wkbSEXP);
+    Rcpp::traits::input_parameter< const int >::type factor_levels(factor_levelsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type typed(typedSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type units(unitsSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type id_type(id_typeSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_osmdata_sf(st, merge_lines, resolve_relations, area_tags, wkb, factor_levels, typed, units, id_type));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -0,0 +1,645 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       arrow-ipc.cpp
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osm-router.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Minimal writer of Apache Arrow IPC files and streams.
+ *
+ *  Limitations:    Little-endian platforms only, as declared in the schema.
+ *
+ *  Dependencies:       none
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#include "arrow-ipc.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+
+// The IPC format is described at
+// https://arrow.apache.org/docs/format/Columnar.html#serialization-and-interprocess-communication-ipc
+// Message metadata are flatbuffers defined in 'Message.fbs' and 'Schema.fbs'
+// of the Arrow repository. These are written here by hand with a small
+// front-to-back builder, so that all offsets point forward, as required of
+// unsigned flatbuffer offsets.
+
+namespace {
+
+// Union type identifiers and enum values from Message.fbs and Schema.fbs
+const uint8_t fb_header_schema = 1, fb_header_record_batch = 3;
+const uint8_t fb_type_int = 2, fb_type_float = 3, fb_type_utf8 = 5,
+      fb_type_list = 12, fb_type_struct = 13, fb_type_fixed_size_list = 16;
+const int16_t fb_metadata_v5 = 4, fb_precision_double = 2;
+
+const uint32_t ipc_continuation = 0xFFFFFFFF;
+const char ipc_magic [] = "ARROW1";
+
+class FlatBuilder;
+typedef std::function <size_t (FlatBuilder &)> FbChild;
+
+/* One field of a flatbuffer table, either an inline scalar of 'size' bytes, or
+ * (for size == 0) an offset to a child object written by 'child'. */
+struct FbField
+{
+    uint16_t slot;
+    uint8_t size;
+    uint64_t value;
+    FbChild child;
+};
+
+FbField fb_scalar (const uint16_t slot, const uint8_t size, const uint64_t value)
+{
+    return FbField {slot, size, value, nullptr};
+}
+
+FbField fb_offset (const uint16_t slot, FbChild child)
+{
+    return FbField {slot, 0, 0, child};
+}
+
+class FlatBuilder
+{
+    public:
+
+        std::vector <uint8_t> buf;
+
+        void pad (const size_t align)
+        {
+            while (buf.size () % align != 0)
+                buf.push_back (0);
+        }
+
+        template <typename T>
+        size_t put (const T x)
+        {
+            pad (sizeof (T));
+            const size_t pos = buf.size ();
+            buf.resize (pos + sizeof (T));
+            std::memcpy (&buf [pos], &x, sizeof (T));
+            return pos;
+        }
+
+        template <typename T>
+        void set (const size_t pos, const T x)
+        {
+            std::memcpy (&buf [pos], &x, sizeof (T));
+        }
+
+        void set_offset (const size_t at, const size_t target)
+        {
+            set <uint32_t> (at, static_cast <uint32_t> (target - at));
+        }
+
+        size_t table (const std::vector <FbField> &fields);
+        size_t string (const std::string &s);
+        size_t table_vector (const std::vector <FbChild> &elements);
+        size_t struct_vector (const std::vector <uint8_t> &bytes,
+                const size_t n);
+        std::vector <uint8_t> finish (FbChild root);
+};
+
+/* Tables are written as vtable, then inline fields (largest first, to minimise
+ * padding), then all child objects. */
+size_t FlatBuilder::table (const std::vector <FbField> &fields)
+{
+    uint16_t nslots = 0;
+    for (auto f: fields)
+        if (f.slot + 1 > nslots)
+            nslots = static_cast <uint16_t> (f.slot + 1);
+
+    pad (2);
+    const size_t vt_pos = buf.size ();
+    const uint16_t vt_size = static_cast <uint16_t> (4 + 2 * nslots);
+    buf.resize (vt_pos + vt_size, 0);
+
+    pad (8);
+    const size_t tbl = buf.size ();
+    put <int32_t> (static_cast <int32_t> (tbl - vt_pos));
+
+    std::vector <size_t> index (fields.size ());
+    for (size_t i = 0; i < fields.size (); i++)
+        index [i] = i;
+    std::stable_sort (index.begin (), index.end (),
+            [&fields] (const size_t a, const size_t b) {
+                const uint8_t sa = fields [a].size == 0 ? 4 : fields [a].size;
+                const uint8_t sb = fields [b].size == 0 ? 4 : fields [b].size;
+                return sa > sb; });
+
+    std::vector <size_t> field_pos (fields.size ());
+    for (auto i: index)
+    {
+        const uint8_t size = fields [i].size == 0 ? 4 : fields [i].size;
+        pad (size);
+        field_pos [i] = buf.size ();
+        for (uint8_t b = 0; b < size; b++)
+            buf.push_back (static_cast <uint8_t> (fields [i].value >> (8 * b)));
+        set <uint16_t> (vt_pos + 4 + 2 * fields [i].slot,
+                static_cast <uint16_t> (field_pos [i] - tbl));
+    }
+    set <uint16_t> (vt_pos, vt_size);
+    set <uint16_t> (vt_pos + 2, static_cast <uint16_t> (buf.size () - tbl));
+
+    for (size_t i = 0; i < fields.size (); i++)
+        if (fields [i].size == 0)
+            set_offset (field_pos [i], fields [i].child (*this));
+
+    return tbl;
+}
+
+size_t FlatBuilder::string (const std::string &s)
+{
+    const size_t pos = put <uint32_t> (static_cast <uint32_t> (s.size ()));
+    buf.insert (buf.end (), s.begin (), s.end ());
+    buf.push_back (0);
+    return pos;
+}
+
+size_t FlatBuilder::table_vector (const std::vector <FbChild> &elements)
+{
+    const size_t pos = put <uint32_t> (static_cast <uint32_t> (elements.size ()));
+    const size_t first = buf.size ();
+    buf.resize (first + 4 * elements.size (), 0);
+    for (size_t i = 0; i < elements.size (); i++)
+        set_offset (first + 4 * i, elements [i] (*this));
+    return pos;
+}
+
+// All structs used here (FieldNode, Buffer, Block) are 8-byte aligned
+size_t FlatBuilder::struct_vector (const std::vector <uint8_t> &bytes,
+        const size_t n)
+{
+    while ((buf.size () + 4) % 8 != 0)
+        buf.push_back (0);
+    const size_t pos = put <uint32_t> (static_cast <uint32_t> (n));
+    buf.insert (buf.end (), bytes.begin (), bytes.end ());
+    return pos;
+}
+
+std::vector <uint8_t> FlatBuilder::finish (FbChild root)
+{
+    buf.clear ();
+    put <uint32_t> (0);
+    set_offset (0, root (*this));
+    pad (8);
+    return buf;
+}
+
+template <typename T>
+void append_bytes (std::vector <uint8_t> &bytes, const T x)
+{
+    const size_t pos = bytes.size ();
+    bytes.resize (pos + sizeof (T));
+    std::memcpy (&bytes [pos], &x, sizeof (T));
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                          SCHEMA METADATA                           **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+FbChild fb_key_values (
+        const std::vector <std::pair <std::string, std::string> > &kv)
+{
+    return [&kv] (FlatBuilder &fb) {
+        std::vector <FbChild> elements;
+        for (auto &p: kv)
+        {
+            const std::string &key = p.first, &value = p.second;
+            elements.push_back ([&key, &value] (FlatBuilder &fb2) {
+                    return fb2.table ({
+                            fb_offset (0, [&key] (FlatBuilder &b) { return b.string (key); }),
+                            fb_offset (1, [&value] (FlatBuilder &b) { return b.string (value); })
+                            });
+                    });
+        }
+        return fb.table_vector (elements);
+    };
+}
+
+FbChild fb_field (const arrow_ipc::Column &col)
+{
+    return [&col] (FlatBuilder &fb) {
+        uint8_t type_id = 0;
+        std::vector <FbField> type_fields;
+        switch (col.type)
+        {
+            case arrow_ipc::arrow_type::int64:
+                type_id = fb_type_int;
+                type_fields = {fb_scalar (0, 4, 64), fb_scalar (1, 1, 1)};
+                break;
+            case arrow_ipc::arrow_type::float64:
+                type_id = fb_type_float;
+                type_fields = {fb_scalar (0, 2, fb_precision_double)};
+                break;
+            case arrow_ipc::arrow_type::utf8:
+                type_id = fb_type_utf8;
+                break;
+            case arrow_ipc::arrow_type::list:
+                type_id = fb_type_list;
+                break;
+            case arrow_ipc::arrow_type::fixed_size_list:
+                type_id = fb_type_fixed_size_list;
+                type_fields = {fb_scalar (0, 4,
+                        static_cast <uint64_t> (col.list_size))};
+                break;
+            case arrow_ipc::arrow_type::struct_:
+                type_id = fb_type_struct;
+                break;
+        }
+
+        std::vector <FbField> fields = {
+            fb_offset (0, [&col] (FlatBuilder &b) { return b.string (col.name); }),
+            fb_scalar (1, 1, col.nullable ? 1 : 0),
+            fb_scalar (2, 1, type_id),
+            fb_offset (3, [type_fields] (FlatBuilder &b) {
+                    return b.table (type_fields); }),
+            fb_offset (5, [&col] (FlatBuilder &b) {
+                    std::vector <FbChild> children;
+                    for (auto &ch: col.children)
+                        children.push_back (fb_field (ch));
+                    return b.table_vector (children); })
+        };
+        if (col.metadata.size () > 0)
+            fields.push_back (fb_offset (6, fb_key_values (col.metadata)));
+
+        return fb.table (fields);
+    };
+}
+
+FbChild fb_schema (const std::vector <arrow_ipc::Column> &columns)
+{
+    return [&columns] (FlatBuilder &fb) {
+        return fb.table ({
+                fb_scalar (0, 2, 0), // little endian
+                fb_offset (1, [&columns] (FlatBuilder &b) {
+                        std::vector <FbChild> fields;
+                        for (auto &col: columns)
+                            fields.push_back (fb_field (col));
+                        return b.table_vector (fields); })
+                });
+    };
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                         RECORD BATCH BODY                          **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+struct BodyBuffer
+{
+    const uint8_t *data;
+    size_t size;
+};
+
+/* Collect field nodes and buffers of one column and all of its children, in
+ * the depth-first order required by the IPC format. */
+void flatten_column (const arrow_ipc::Column &col,
+        std::vector <uint8_t> &nodes, std::vector <BodyBuffer> &buffers)
+{
+    append_bytes <int64_t> (nodes, col.length);
+    append_bytes <int64_t> (nodes, col.null_count);
+
+    if (col.null_count > 0)
+        buffers.push_back ({col.validity.data (), col.validity.size ()});
+    else
+        buffers.push_back ({nullptr, 0});
+
+    switch (col.type)
+    {
+        case arrow_ipc::arrow_type::int64:
+        case arrow_ipc::arrow_type::float64:
+            buffers.push_back ({col.data.data (), col.data.size ()});
+            break;
+        case arrow_ipc::arrow_type::utf8:
+            buffers.push_back ({reinterpret_cast <const uint8_t *>
+                    (col.offsets.data ()), col.offsets.size () * sizeof (int32_t)});
+            buffers.push_back ({col.data.data (), col.data.size ()});
+            break;
+        case arrow_ipc::arrow_type::list:
+            buffers.push_back ({reinterpret_cast <const uint8_t *>
+                    (col.offsets.data ()), col.offsets.size () * sizeof (int32_t)});
+            break;
+        case arrow_ipc::arrow_type::fixed_size_list:
+        case arrow_ipc::arrow_type::struct_:
+            break;
+    }
+
+    for (auto &ch: col.children)
+        flatten_column (ch, nodes, buffers);
+}
+
+size_t padded_size (const size_t n)
+{
+    return (n + 7) / 8 * 8;
+}
+
+/* Block positions of the record batch are needed for the file footer */
+struct Block
+{
+    int64_t offset;
+    int32_t metadata_length;
+    int64_t body_length;
+};
+
+class IpcFile
+{
+    private:
+
+        std::ofstream m_out;
+        int64_t m_pos = 0;
+
+        void write (const void *data, const size_t size)
+        {
+            m_out.write (static_cast <const char *> (data),
+                    static_cast <std::streamsize> (size));
+            m_pos += static_cast <int64_t> (size);
+        }
+
+        void write_padding (const size_t size)
+        {
+            const char zeros [8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            write (zeros, padded_size (size) - size);
+        }
+
+    public:
+
+        IpcFile (const std::string &path)
+        {
+            m_out.open (path, std::ios::binary | std::ios::trunc);
+            if (!m_out.is_open ())
+                throw std::runtime_error ("unable to open file " + path);
+        }
+
+        int64_t pos () const { return m_pos; }
+
+        void write_magic ()
+        {
+            write (ipc_magic, 6);
+            write_padding (6);
+        }
+
+        // Encapsulated message: continuation, metadata size, metadata, body
+        Block write_message (const std::vector <uint8_t> &metadata,
+                const std::vector <BodyBuffer> &body, const int64_t body_length)
+        {
+            Block block;
+            block.offset = m_pos;
+            const int32_t meta_size = static_cast <int32_t> (metadata.size ());
+            write (&ipc_continuation, 4);
+            write (&meta_size, 4);
+            write (metadata.data (), metadata.size ());
+            for (auto &b: body)
+            {
+                if (b.size > 0)
+                    write (b.data, b.size);
+                write_padding (b.size);
+            }
+            block.metadata_length = 8 + meta_size;
+            block.body_length = body_length;
+            return block;
+        }
+
+        void write_eos ()
+        {
+            const int32_t zero = 0;
+            write (&ipc_continuation, 4);
+            write (&zero, 4);
+        }
+
+        void write_footer (const std::vector <uint8_t> &footer)
+        {
+            const int32_t size = static_cast <int32_t> (footer.size ());
+            write (footer.data (), footer.size ());
+            write (&size, 4);
+            write (ipc_magic, 6);
+        }
+
+        void close ()
+        {
+            m_out.close ();
+            if (m_out.fail ())
+                throw std::runtime_error ("error writing arrow file");
+        }
+};
+
+} // end anonymous namespace
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                          COLUMN BUILDERS                           **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+void arrow_ipc::StringColumn::pad_to (const int64_t row)
+{
+    while (m_nrow < row)
+    {
+        m_offsets.push_back (m_offsets.back ());
+        if (m_nrow % 8 == 0)
+            m_validity.push_back (0);
+        m_nrow++;
+    }
+}
+
+void arrow_ipc::StringColumn::set (const int64_t row, const std::string &value)
+{
+    if (row < m_nrow)
+        throw std::runtime_error ("string column rows must be set in order");
+    pad_to (row);
+    m_data.insert (m_data.end (), value.begin (), value.end ());
+    m_offsets.push_back (static_cast <int32_t> (m_data.size ()));
+    if (m_nrow % 8 == 0)
+        m_validity.push_back (0);
+    m_validity.back () |= static_cast <uint8_t> (1 << (m_nrow % 8));
+    m_nrow++;
+}
+
+arrow_ipc::Column arrow_ipc::StringColumn::finish (const std::string &name,
+        const int64_t nrow)
+{
+    pad_to (nrow);
+
+    Column col;
+    col.name = name;
+    col.type = arrow_type::utf8;
+    col.nullable = true;
+    col.length = nrow;
+    col.null_count = 0;
+    for (int64_t i = 0; i < nrow; i++)
+        if (!(m_validity [static_cast <size_t> (i / 8)] & (1 << (i % 8))))
+            col.null_count++;
+    if (col.null_count > 0)
+        col.validity.swap (m_validity);
+    col.offsets.swap (m_offsets);
+    col.data.swap (m_data);
+
+    return col;
+}
+
+arrow_ipc::Column arrow_ipc::int64_column (const std::string &name,
+        const std::vector <int64_t> &values)
+{
+    Column col;
+    col.name = name;
+    col.type = arrow_type::int64;
+    col.length = static_cast <int64_t> (values.size ());
+    col.data.resize (values.size () * sizeof (int64_t));
+    if (values.size () > 0)
+        std::memcpy (col.data.data (), values.data (), col.data.size ());
+    return col;
+}
+
+arrow_ipc::Column arrow_ipc::float64_column (const std::string &name,
+        const std::vector <double> &values)
+{
+    Column col;
+    col.name = name;
+    col.type = arrow_type::float64;
+    col.length = static_cast <int64_t> (values.size ());
+    col.data.resize (values.size () * sizeof (double));
+    if (values.size () > 0)
+        std::memcpy (col.data.data (), values.data (), col.data.size ());
+    return col;
+}
+
+arrow_ipc::Column arrow_ipc::list_column (const std::string &name,
+        const std::vector <int32_t> &offsets, Column child)
+{
+    if (offsets.size () == 0 || offsets.back () != child.length)
+        throw std::runtime_error ("list offsets do not match child length");
+
+    Column col;
+    col.name = name;
+    col.type = arrow_type::list;
+    col.length = static_cast <int64_t> (offsets.size ()) - 1;
+    col.offsets = offsets;
+    col.children.push_back (std::move (child));
+    return col;
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                            WRITE_TABLE                             **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+/* write_table
+ *
+ * Write columns to an Arrow IPC file or stream as a single record batch.
+ *
+ * @param path Name of file to be written
+ * @param columns Columns of equal lengths
+ * @param stream If true, write the IPC streaming format, otherwise the IPC
+ *        file format (which adds magic bytes and a footer to the stream).
+ */
+void arrow_ipc::write_table (const std::string &path,
+        const std::vector <Column> &columns, const bool stream)
+{
+    const int64_t nrow = columns.size () > 0 ? columns [0].length : 0;
+    for (auto &col: columns)
+        if (col.length != nrow)
+            throw std::runtime_error ("arrow columns must have equal lengths");
+
+    std::vector <uint8_t> nodes, buffers_meta;
+    std::vector <BodyBuffer> body;
+    for (auto &col: columns)
+        flatten_column (col, nodes, body);
+
+    int64_t body_length = 0;
+    for (auto &b: body)
+    {
+        append_bytes <int64_t> (buffers_meta, body_length);
+        append_bytes <int64_t> (buffers_meta, static_cast <int64_t> (b.size));
+        body_length += static_cast <int64_t> (padded_size (b.size));
+    }
+
+    FlatBuilder fb;
+    const std::vector <uint8_t> schema_msg = fb.finish ([&columns] (FlatBuilder &b) {
+            return b.table ({
+                    fb_scalar (0, 2, fb_metadata_v5),
+                    fb_scalar (1, 1, fb_header_schema),
+                    fb_offset (2, fb_schema (columns)),
+                    fb_scalar (3, 8, 0)
+                    });
+            });
+
+    const size_t nnodes = nodes.size () / 16, nbuffers = body.size ();
+    const std::vector <uint8_t> batch_msg = fb.finish (
+            [&] (FlatBuilder &b) {
+            return b.table ({
+                    fb_scalar (0, 2, fb_metadata_v5),
+                    fb_scalar (1, 1, fb_header_record_batch),
+                    fb_offset (2, [&] (FlatBuilder &b2) {
+                            return b2.table ({
+                                    fb_scalar (0, 8, static_cast <uint64_t> (nrow)),
+                                    fb_offset (1, [&] (FlatBuilder &b3) {
+                                            return b3.struct_vector (nodes, nnodes); }),
+                                    fb_offset (2, [&] (FlatBuilder &b3) {
+                                            return b3.struct_vector (buffers_meta, nbuffers); })
+                                    });
+                            }),
+                    fb_scalar (3, 8, static_cast <uint64_t> (body_length))
+                    });
+            });
+
+    IpcFile out (path);
+    if (!stream)
+        out.write_magic ();
+    out.write_message (schema_msg, {}, 0);
+    const Block block = out.write_message (batch_msg, body, body_length);
+    out.write_eos ();
+
+    if (!stream)
+    {
+        std::vector <uint8_t> blocks;
+        append_bytes <int64_t> (blocks, block.offset);
+        append_bytes <int32_t> (blocks, block.metadata_length);
+        append_bytes <int32_t> (blocks, 0);
+        append_bytes <int64_t> (blocks, block.body_length);
+
+        const std::vector <uint8_t> footer = fb.finish (
+                [&] (FlatBuilder &b) {
+                return b.table ({
+                        fb_scalar (0, 2, fb_metadata_v5),
+                        fb_offset (1, fb_schema (columns)),
+                        fb_offset (2, [] (FlatBuilder &b2) {
+                                return b2.struct_vector ({}, 0); }),
+                        fb_offset (3, [&blocks] (FlatBuilder &b2) {
+                                return b2.struct_vector (blocks, 1); })
+                        });
+                });
+        out.write_footer (footer);
+    }
+
+    out.close ();
+}
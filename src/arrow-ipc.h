@@ -0,0 +1,95 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       arrow-ipc.h
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osm-router.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Minimal writer of Apache Arrow IPC files and streams (no
+ *                  Rcpp here, and no dependency on the Arrow libraries).
+ *
+ *  Limitations:    Only the column types needed for OSM data are supported:
+ *                  int64, float64, utf8, list, fixed_size_list, and struct.
+ *                  All data are written in a single record batch, without
+ *                  compression or dictionary encoding.
+ *
+ *  Dependencies:       none
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace arrow_ipc {
+
+enum class arrow_type { int64, float64, utf8, list, fixed_size_list, struct_ };
+
+/* One Arrow array together with its field description. Nested types (lists,
+ * structs) hold their child arrays in 'children'. Buffers are stored exactly as
+ * they are to be written in the IPC body. */
+struct Column
+{
+    std::string name;
+    arrow_type type;
+    bool nullable = false;
+    int32_t list_size = 0; // only for fixed_size_list
+    int64_t length = 0, null_count = 0;
+    std::vector <uint8_t> validity; // empty if null_count == 0
+    std::vector <int32_t> offsets; // utf8 and list
+    std::vector <uint8_t> data; // int64, float64, and utf8
+    std::vector <Column> children;
+    std::vector <std::pair <std::string, std::string> > metadata;
+};
+
+/* Builder for nullable utf8 columns, filled row-by-row in arbitrary order of
+ * columns, so that sparse tags can be added in a single pass over all objects.
+ * Rows which are never set are null. */
+class StringColumn
+{
+    private:
+        int64_t m_nrow = 0;
+        std::vector <uint8_t> m_validity;
+        std::vector <int32_t> m_offsets;
+        std::vector <uint8_t> m_data;
+
+        void pad_to (const int64_t row);
+
+    public:
+        StringColumn () : m_offsets (1, 0) {}
+
+        void set (const int64_t row, const std::string &value);
+        Column finish (const std::string &name, const int64_t nrow);
+};
+
+Column int64_column (const std::string &name,
+        const std::vector <int64_t> &values);
+
+Column float64_column (const std::string &name,
+        const std::vector <double> &values);
+
+Column list_column (const std::string &name,
+        const std::vector <int32_t> &offsets, Column child);
+
+void write_table (const std::string &path, const std::vector <Column> &columns,
+        const bool stream);
+
+} // end namespace arrow_ipc
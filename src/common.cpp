@@ -1,6 +1,8 @@
 
 #include "common.h"
 
+#include <climits>
+
 // APS sadly xml_document has no copy constructor, so despite NRVO/copy elision,
 // cannot return by value.  This forces us into using a unique_ptr
 XmlDocPtr parseXML (const std::string& xmlString)
@@ -9,3 +11,62 @@ XmlDocPtr parseXML (const std::string& xmlString)
     doc->parse<static_cast<long>(0)> (const_cast<char*> (xmlString.c_str()));
     return doc;
 }
+
+// Decimal integers without leading zeros (which would be lost, for example
+// from "ref" values), and within the range of R integers.
+bool parse_integer (const char *p, const size_t n, int &val)
+{
+    size_t i = (n > 0 && p [0] == '-') ? 1 : 0;
+    const size_t ndigits = n - i;
+    if (ndigits == 0 || ndigits > 10 || (p [i] == '0' && ndigits > 1))
+        return false;
+
+    long long x = 0;
+    for (; i < n; i++)
+    {
+        if (p [i] < '0' || p [i] > '9')
+            return false;
+        x = 10 * x + (p [i] - '0');
+    }
+    if (p [0] == '-')
+        x = -x;
+    if (x <= INT_MIN || x > INT_MAX) // INT_MIN is NA_integer_
+        return false;
+
+    val = static_cast <int> (x);
+    return true;
+}
+
+// Plain decimal numbers, with optional fraction and exponent. Unlike strtod,
+// this rejects "inf", "nan", hexadecimal values, and surrounding whitespace.
+bool is_real (const char *p, const size_t n)
+{
+    size_t i = (n > 0 && (p [0] == '-' || p [0] == '+')) ? 1 : 0;
+    const size_t i0 = i;
+    while (i < n && p [i] >= '0' && p [i] <= '9')
+        i++;
+    if (i - i0 > 1 && p [i0] == '0')
+        return false;
+    size_t ndigits = i - i0;
+    if (i < n && p [i] == '.')
+    {
+        const size_t i1 = ++i;
+        while (i < n && p [i] >= '0' && p [i] <= '9')
+            i++;
+        ndigits += i - i1;
+    }
+    if (ndigits == 0)
+        return false;
+    if (i < n && (p [i] == 'e' || p [i] == 'E'))
+    {
+        i++;
+        if (i < n && (p [i] == '-' || p [i] == '+'))
+            i++;
+        const size_t i2 = i;
+        while (i < n && p [i] >= '0' && p [i] <= '9')
+            i++;
+        if (i == i2)
+            return false;
+    }
+    return i == n;
+}
@@ -53,6 +53,7 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <cstring>
 #include <sstream>
@@ -87,6 +88,8 @@ typedef const rapidxml::xml_attribute<>* XmlAttrPtr;
 
 // ----- functions in common.cpp
 XmlDocPtr parseXML (const std::string& xmlString);
+bool parse_integer (const char *p, const size_t n, int &val);
+bool is_real (const char *p, const size_t n);
 // ----- end functions in common.cpp
 
 struct UniqueVals
@@ -104,7 +107,19 @@ struct UniqueVals
     std::set <std::string> k_point, k_way, k_rel;
     // A numeric index is also constructed to enable direct indexing into
     // key-val matrices. This is an unsigned int for indexing into Rcpp objects.
-    std::map <std::string, unsigned int> k_point_index, k_way_index, k_rel_index;
+    // Hashing makes each lookup constant-time, regardless of the number of
+    // distinct keys.
+    std::unordered_map <std::string, unsigned int> k_point_index, k_way_index,
+        k_rel_index;
+    // Column names, to which the indices above refer. Keys which differ only
+    // in case share one column, so there may be fewer names than keys. Keys
+    // which clash with other columns of each output are only renamed on
+    // conversion (see osm_convert::rename_reserved).
+    std::vector <std::string> k_point_names, k_way_names, k_rel_names;
+    // Column names of all keys, and those keys which share the column of
+    // another key, and only fill cells for which that key has no value.
+    std::unordered_map <std::string, std::string> k_names;
+    std::unordered_set <std::string> k_merged;
 };
 
 struct RawNode
@@ -143,6 +158,7 @@ struct OneWay
     double _lat = NA_REAL, _lon = NA_REAL; // center
     std::map <std::string, std::string> key_val;
     std::vector <osmid_t> nodes;
+    bool ispoly = false; // set at parse time; see XmlData::is_area
 };
 
 struct RawRelation
@@ -175,6 +191,8 @@ struct Relation
 
 typedef std::vector <Relation> Relations;
 typedef std::map <osmid_t, OneWay> Ways;
+// Ordered vectors of iterators used to index polygonal and non-polygonal ways
+typedef std::vector <Ways::const_iterator> WayIndex;
 
 // MP: osmid_t (long long) is Node.id, and thus repetitive, but traverseNode has
 // to store the ID in the Node struct first, before this can be used to make the
@@ -31,6 +31,49 @@
 
 #include "convert-osm-rcpp.h"
 
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// OSM values of logical tags, or NA_LOGICAL for any other value
+int logical_value (const char *p)
+{
+    if (!strcmp (p, "yes") || !strcmp (p, "true"))
+        return TRUE;
+    if (!strcmp (p, "no") || !strcmp (p, "false"))
+        return FALSE;
+    return NA_LOGICAL;
+}
+
+// Numbers, optionally followed by one of the unit suffixes, which may be
+// separated by spaces, and which multiply the number by the unit factor.
+bool parse_number (const char *p, const size_t n,
+        const osm_convert::UnitRules &units, double &val)
+{
+    if (is_real (p, n))
+    {
+        val = std::strtod (p, nullptr);
+        return true;
+    }
+    for (const auto &u: units)
+    {
+        const size_t len = u.first.size ();
+        if (n <= len || u.first.compare (0, len, p + n - len, len) != 0)
+            continue;
+        size_t m = n - len;
+        while (m > 0 && p [m - 1] == ' ')
+            m--;
+        if (is_real (p, m))
+        {
+            val = std::strtod (std::string (p, m).c_str (), nullptr) * u.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // end anonymous namespace
 
 /************************************************************************
  ************************************************************************
@@ -42,19 +85,13 @@
 
 /* Traces a single way and adds (lon,lat,rownames) to an Rcpp::NumericMatrix
  *
- * @param &ways pointer to Ways structure
+ * @param wayi Constant iterator to one OSM way
  * @param &nodes pointer to Nodes structure
- * @param first_node Last node of previous way to find in current
- * @param &wayi_id pointer to ID of current way
- * @lons pointer to vector of longitudes
- * @lats pointer to vector of latitutdes
- * @rownames pointer to vector of rownames for each node.
  * @nmat Rcpp::NumericMatrix to store lons, lats, and rownames
  */
-void osm_convert::trace_way_nmat (const Ways &ways, const Nodes &nodes, 
-        const osmid_t &wayi_id, Rcpp::NumericMatrix &nmat)
+void osm_convert::trace_way_nmat (Ways::const_iterator wayi,
+        const Nodes &nodes, Rcpp::NumericMatrix &nmat)
 {
-    auto wayi = ways.find (wayi_id);
     std::vector <std::string> rownames;
     rownames.clear ();
     size_t n = wayi->second.nodes.size ();
@@ -83,11 +120,13 @@ void osm_convert::trace_way_nmat (const Ways &ways, const Nodes &nodes,
 
 /* get_value_mat_way
  *
- * Extract key-value pairs for a given way and fill Rcpp::CharacterMatrix
+ * Extract OSM ID and key-value pairs for a given way and fill
+ * Rcpp::CharacterMatrix
  *
  * @param wayi Constant iterator to one OSM way
  * @param Ways Pointer to the std::vector of all ways
  * @param unique_vals Pointer to the UniqueVals structure
+ * @param cols Columns of 'value_arr'
  * @param value_arr Pointer to the Rcpp::CharacterMatrix of values to be filled
  *        by tracing the key-val pairs of the way 'wayi'
  * @param rowi Integer value for the key-val pairs for wayi
@@ -96,119 +135,346 @@ void osm_convert::trace_way_nmat (const Ways &ways, const Nodes &nodes,
 // Rcpp::CharacterMatrix and then simply
 // Rcpp::CharacterMatrix mat (nrow, ncol, value_vec.begin ()); ?
 void osm_convert::get_value_mat_way (Ways::const_iterator wayi,
-        const UniqueVals &unique_vals, Rcpp::CharacterMatrix &value_arr,
-        unsigned int rowi)
+        const UniqueVals &unique_vals, const KvColumns &cols,
+        Rcpp::CharacterMatrix &value_arr, unsigned int rowi)
 {
+    osm_convert::set_utf8 (value_arr, rowi, 0, std::to_string (wayi->first));
     for (auto kv_iter = wayi->second.key_val.begin ();
             kv_iter != wayi->second.key_val.end (); ++kv_iter)
     {
         const std::string &key = kv_iter->first;
-        unsigned int coli = unique_vals.k_way_index.at (key);
-        value_arr (rowi, coli) = kv_iter->second;
+        size_t coli = cols.col (unique_vals.k_way_index.at (key));
+        if (osm_convert::keep_value (unique_vals, key, value_arr (rowi, coli)))
+            osm_convert::set_utf8 (value_arr, rowi, coli, kv_iter->second);
     }
 }
 
 /* get_value_mat_rel
  *
- * Extract key-value pairs for a given relation and fill Rcpp::CharacterMatrix
+ * Extract OSM ID and key-value pairs for a given relation and fill
+ * Rcpp::CharacterMatrix
  *
  * @param reli Constant iterator to one OSM relation
  * @param rels Pointer to the std::vector of all relations
  * @param unique_vals Pointer to the UniqueVals structure
+ * @param cols Columns of 'value_arr'
  * @param value_arr Pointer to the Rcpp::CharacterMatrix of values to be filled
  *        by tracing the key-val pairs of the relation 'reli'
  * @param rowi Integer value for the key-val pairs for reli
  */
 void osm_convert::get_value_mat_rel (Relations::const_iterator &reli,
-        const UniqueVals &unique_vals, Rcpp::CharacterMatrix &value_arr,
-        unsigned int rowi)
+        const UniqueVals &unique_vals, const KvColumns &cols,
+        Rcpp::CharacterMatrix &value_arr, unsigned int rowi)
 {
+    osm_convert::set_utf8 (value_arr, rowi, 0, std::to_string (reli->id));
     for (auto kv_iter = reli->key_val.begin (); kv_iter != reli->key_val.end ();
             ++kv_iter)
     {
         const std::string &key = kv_iter->first;
-        unsigned int coli = unique_vals.k_rel_index.at (key);
-        value_arr (rowi, coli) = kv_iter->second;
+        size_t coli = cols.col (unique_vals.k_rel_index.at (key));
+        if (osm_convert::keep_value (unique_vals, key, value_arr (rowi, coli)))
+            osm_convert::set_utf8 (value_arr, rowi, coli, kv_iter->second);
     }
 }
 
 
-/* restructure_kv_mat
+const osm_convert::ReservedNames osm_convert::sf_reserved = {"osm_id",
+    "osm_version", "osm_timestamp", "osm_changeset", "osm_uid", "osm_user",
+    "geometry"};
+const osm_convert::ReservedNames osm_convert::sf_reserved_ls = {"osm_id",
+    "osm_version", "osm_timestamp", "osm_changeset", "osm_uid", "osm_user",
+    "geometry", "role"};
+const osm_convert::ReservedNames osm_convert::sp_reserved = {"osm_id"};
+
+/* rename_reserved
+ *
+ * Rename any keys which clash with other columns of an output by appending
+ * ".n", with 'n' the first number for which the name is unique.
  *
- * Restructures a key-value matrix to reflect typical GDAL output by
- * inserting a first column containing "osm_id" and moving the "name" column to
- * second position.
+ * @param keys Column names of keys, as in 'UniqueVals'
+ * @param reserved Names of all other columns of the output
+ * @param renamed New names of any renamed keys are inserted here.
  *
- * @param kv Pointer to the key-value matrix to be restructured
- * @param ls true only for multilinestrings, which have compound rownames which
- *        include roles
+ * @return Final column names of 'keys'.
  */
-Rcpp::CharacterMatrix osm_convert::restructure_kv_mat (Rcpp::CharacterMatrix &kv, bool ls=false)
+std::vector <std::string> osm_convert::rename_reserved (
+        const std::vector <std::string> &keys, const ReservedNames &reserved,
+        std::set <std::string> &renamed)
 {
-    // The following has to be done in 2 lines:
-    std::vector <std::vector <std::string> > dims = kv.attr ("dimnames");
-    std::vector <std::string> ids = dims [0], varnames = dims [1], varnames_new;
-    Rcpp::CharacterMatrix kv_out;
-
-    int ni = static_cast <int> (std::distance (varnames.begin (),
-            std::find (varnames.begin (), varnames.end (), "name")));
-    unsigned int add_lines = 1;
+    std::vector <std::string> out (keys);
+    std::unordered_set <std::string> used;
+    for (size_t i = 0; i < keys.size (); i++)
+    {
+        if (reserved.count (keys [i]) == 0)
+            continue;
+        if (used.empty ())
+            used.insert (keys.begin (), keys.end ());
+        std::string name;
+        for (int n = 1; name.empty () || reserved.count (name) > 0 ||
+                used.count (name) > 0; n++)
+            name = keys [i] + "." + std::to_string (n);
+        used.insert (name);
+        renamed.insert (name);
+        out [i] = name;
+    }
+
+    return out;
+}
+
+/* KvColumns::names
+ *
+ * Column names of a key-value matrix, in the order described in
+ * convert-osm-rcpp.h.
+ */
+Rcpp::CharacterVector osm_convert::KvColumns::names () const
+{
+    std::set <std::string> renamed;
+    const std::vector <std::string> key_names = rename_reserved (keys,
+            reserved, renamed);
+
+    Rcpp::CharacterVector nms (static_cast <R_xlen_t> (ncol ()));
+    osm_convert::set_utf8 (nms, 0, "osm_id");
     if (ls)
-        add_lines++;
+        osm_convert::set_utf8 (nms, static_cast <R_xlen_t> (role ()), "role");
+    for (unsigned int i = 0; i < keys.size (); i++)
+        osm_convert::set_utf8 (nms, static_cast <R_xlen_t> (col (i)),
+                key_names [i]);
 
-    // This only processes entries that have key = "name". Those that don't do
-    // not get their osm_id values appended. It's then easier to post-append
-    // these, rather than modify this code
-    if (ni < static_cast <int> (varnames.size ()))
-    {
-        Rcpp::CharacterVector name_vals = kv.column (ni);
-        Rcpp::CharacterVector roles; // only for ls, but has to be defined here
-        // convert ids to CharacterVector - direct allocation doesn't work
-        Rcpp::CharacterVector ids_rcpp (ids.size ());
-        if (!ls)
-            for (unsigned int i=0; i<ids.size (); i++)
-                ids_rcpp (i) = ids [i];
-        else
-        { // extract way roles for multilinestring kev-val matrices
-            roles = Rcpp::CharacterVector (ids.size ());
-            for (unsigned int i=0; i<ids.size (); i++)
-            {
-                size_t ipos = ids [i].find ("-", 0);
-                ids_rcpp (i) = ids [i].substr (0, ipos).c_str ();
-                roles (i) = ids [i].substr (ipos + 1, ids[i].length () - ipos);
-            }
-        }
+    return nms;
+}
 
-        varnames_new.reserve (static_cast <unsigned int> (kv.ncol ()) +
-                add_lines);
-        varnames_new.push_back ("osm_id");
-        varnames_new.push_back ("name");
-        kv_out = Rcpp::CharacterMatrix (Rcpp::Dimension (
-                    static_cast <unsigned int> (kv.nrow ()),
-                    static_cast <unsigned int> (kv.ncol ()) + add_lines));
-        kv_out.column (0) = ids_rcpp;
-        kv_out.column (1) = name_vals;
-        if (ls)
+/* as_factor
+ *
+ * Convert a character vector to a factor if it has no more than 'max_levels'
+ * distinct values. All strings are held in R's global cache of CHARSXPs, so
+ * equal values are identical pointers, and are counted without hashing their
+ * contents.
+ *
+ * @param x Character vector
+ * @param max_levels Maximal number of levels
+ *
+ * @return A factor with levels in byte order, or 'x' itself if it has more
+ *         than 'max_levels' distinct values.
+ */
+SEXP osm_convert::as_factor (const Rcpp::CharacterVector &x,
+        const size_t max_levels)
+{
+    const R_xlen_t n = x.size ();
+    std::unordered_map <SEXP, int> codes;
+    Rcpp::IntegerVector f (n);
+    for (R_xlen_t i = 0; i < n; i++)
+    {
+        SEXP s = STRING_ELT (x, i);
+        if (s == NA_STRING)
         {
-            varnames_new.push_back ("role");
-            kv_out.column (2) = roles;
+            f [i] = NA_INTEGER;
+            continue;
         }
-        int count = 1 + static_cast <int> (add_lines);
-        int i_int = 0;
-        for (unsigned int i=0; i<static_cast <unsigned int> (kv.ncol ()); i++)
+        auto it = codes.emplace (s, static_cast <int> (codes.size ()) + 1);
+        if (it.second && codes.size () > max_levels)
+            return x;
+        f [i] = it.first->second;
+    }
+
+    std::vector <SEXP> levels;
+    levels.reserve (codes.size ());
+    for (const auto &c: codes)
+        levels.push_back (c.first);
+    std::sort (levels.begin (), levels.end (), [] (SEXP a, SEXP b) {
+            return strcmp (CHAR (a), CHAR (b)) < 0; });
+
+    std::vector <int> recode (codes.size () + 1);
+    Rcpp::CharacterVector lev (levels.size ());
+    for (size_t i = 0; i < levels.size (); i++)
+    {
+        SET_STRING_ELT (lev, static_cast <R_xlen_t> (i), levels [i]);
+        recode [static_cast <size_t> (codes.at (levels [i]))] =
+            static_cast <int> (i) + 1;
+    }
+    for (R_xlen_t i = 0; i < n; i++)
+        if (f [i] != NA_INTEGER)
+            f [i] = recode [static_cast <size_t> (f [i])];
+
+    f.attr ("levels") = lev;
+    f.attr ("class") = "factor";
+    return f;
+}
+
+/* unit_rules
+ *
+ * Convert a named vector of multipliers of unit suffixes into rules for
+ * 'as_typed', with longer suffixes first, so that "km/h" is matched before any
+ * rule for "h".
+ */
+osm_convert::UnitRules osm_convert::unit_rules (const Rcpp::NumericVector &units)
+{
+    UnitRules rules;
+    if (units.size () == 0)
+        return rules;
+
+    Rcpp::CharacterVector nms = units.names ();
+    for (R_xlen_t i = 0; i < units.size (); i++)
+        rules.emplace_back (CHAR (STRING_ELT (nms, i)), units [i]);
+    std::stable_sort (rules.begin (), rules.end (),
+            [] (const UnitRules::value_type &a, const UnitRules::value_type &b) {
+                return a.first.size () > b.first.size (); });
+
+    return rules;
+}
+
+/* as_typed
+ *
+ * Convert a character vector of tag values to a logical, integer, or numeric
+ * vector if all non-missing values conform. Logical values are "yes" and "no",
+ * or "true" and "false". Numbers with unit suffixes are multiplied by the
+ * factors of those units, and always give numeric vectors.
+ *
+ * @param x Character vector
+ * @param units Rules for unit suffixes from 'unit_rules'
+ *
+ * @return The converted vector, or 'x' itself if any value does not conform,
+ *         or if all values are missing.
+ */
+SEXP osm_convert::as_typed (const Rcpp::CharacterVector &x,
+        const UnitRules &units)
+{
+    const R_xlen_t n = x.size ();
+    bool any_value = false, is_lgl = true, is_int = true, is_num = true;
+    int ival;
+    double dval;
+    for (R_xlen_t i = 0; i < n && (is_lgl || is_num); i++)
+    {
+        SEXP s = STRING_ELT (x, i);
+        if (s == NA_STRING)
+            continue;
+        any_value = true;
+        const char *p = CHAR (s);
+        const size_t len = static_cast <size_t> (LENGTH (s));
+        if (is_lgl && logical_value (p) == NA_LOGICAL)
+            is_lgl = false;
+        if (is_int && !parse_integer (p, len, ival))
+            is_int = false;
+        if (is_num && !is_int && !parse_number (p, len, units, dval))
+            is_num = false;
+    }
+    if (!any_value || !(is_lgl || is_num))
+        return x;
+
+    if (is_lgl)
+    {
+        Rcpp::LogicalVector out (n, NA_LOGICAL);
+        for (R_xlen_t i = 0; i < n; i++)
+            if (STRING_ELT (x, i) != NA_STRING)
+                out [i] = logical_value (CHAR (STRING_ELT (x, i)));
+        return out;
+    } else if (is_int)
+    {
+        Rcpp::IntegerVector out (n, NA_INTEGER);
+        for (R_xlen_t i = 0; i < n; i++)
         {
-            if (i != static_cast <unsigned int> (ni))
-            {
-                varnames_new.push_back (varnames [i]);
-                kv_out.column (count++) = kv.column (i_int);
-            }
-            i_int++;
+            SEXP s = STRING_ELT (x, i);
+            if (s != NA_STRING)
+                parse_integer (CHAR (s), static_cast <size_t> (LENGTH (s)),
+                        out [i]);
         }
-        kv_out.attr ("dimnames") = Rcpp::List::create (ids, varnames_new);
-    } else
-        kv_out = kv;
+        return out;
+    }
 
-    return kv_out;
+    Rcpp::NumericVector out (n, NA_REAL);
+    for (R_xlen_t i = 0; i < n; i++)
+    {
+        SEXP s = STRING_ELT (x, i);
+        if (s != NA_STRING)
+            parse_number (CHAR (s), static_cast <size_t> (LENGTH (s)), units,
+                    out [i]);
+    }
+    return out;
+}
+
+/* type_columns
+ *
+ * Convert all character columns of a key-value data.frame except "osm_id" with
+ * 'as_typed'.
+ *
+ * @param df data.frame, modified in place
+ * @param units Rules for unit suffixes from 'unit_rules'
+ */
+void osm_convert::type_columns (SEXP df, const UnitRules &units)
+{
+    if (TYPEOF (df) != VECSXP)
+        return;
+
+    SEXP nms = Rf_getAttrib (df, R_NamesSymbol);
+    for (R_xlen_t j = 0; j < Rf_xlength (df); j++)
+    {
+        SEXP col = VECTOR_ELT (df, j);
+        if (TYPEOF (col) != STRSXP || (nms != R_NilValue &&
+                    strcmp (CHAR (STRING_ELT (nms, j)), "osm_id") == 0))
+            continue;
+        SET_VECTOR_ELT (df, j, as_typed (col, units));
+    }
+}
+
+/* factorise_columns
+ *
+ * Convert all character columns of a key-value data.frame except "osm_id" to
+ * factors if they have no more than 'max_levels' distinct values.
+ *
+ * @param df data.frame, modified in place
+ * @param max_levels Maximal number of levels, or 0 to leave all columns as
+ *        character
+ */
+void osm_convert::factorise_columns (SEXP df, const int max_levels)
+{
+    if (max_levels <= 0 || TYPEOF (df) != VECSXP)
+        return;
+
+    SEXP nms = Rf_getAttrib (df, R_NamesSymbol);
+    for (R_xlen_t j = 0; j < Rf_xlength (df); j++)
+    {
+        SEXP col = VECTOR_ELT (df, j);
+        if (TYPEOF (col) != STRSXP || (nms != R_NilValue &&
+                    strcmp (CHAR (STRING_ELT (nms, j)), "osm_id") == 0))
+            continue;
+        SET_VECTOR_ELT (df, j, as_factor (col,
+                    static_cast <size_t> (max_levels)));
+    }
+}
+
+/* ids_to_numeric
+ *
+ * Convert the first "osm_id" column of a key-value data.frame to numeric
+ * values, either as doubles, which exactly represent all OSM IDs, or as the
+ * bit patterns of 64-bit integers for 'bit64::integer64' vectors.
+ *
+ * @param df data.frame, modified in place
+ * @param int64 If true, IDs are 'integer64', otherwise double
+ */
+void osm_convert::ids_to_numeric (SEXP df, const bool int64)
+{
+    if (TYPEOF (df) != VECSXP || Rf_xlength (df) == 0)
+        return;
+
+    SEXP nms = Rf_getAttrib (df, R_NamesSymbol);
+    SEXP ids = VECTOR_ELT (df, 0);
+    if (TYPEOF (ids) != STRSXP || nms == R_NilValue ||
+            strcmp (CHAR (STRING_ELT (nms, 0)), "osm_id") != 0)
+        return;
+
+    const R_xlen_t n = Rf_xlength (ids);
+    Rcpp::NumericVector x (n);
+    for (R_xlen_t i = 0; i < n; i++)
+    {
+        const osmid_t id = std::strtoll (CHAR (STRING_ELT (ids, i)),
+                nullptr, 10);
+        if (int64)
+            std::memcpy (&x [i], &id, sizeof (double));
+        else
+            x [i] = static_cast <double> (id);
+    }
+    if (int64)
+        x.attr ("class") = "integer64";
+    SET_VECTOR_ELT (df, 0, x);
 }
 
 /* convert_poly_linestring_to_sf
@@ -284,6 +550,140 @@ template Rcpp::List osm_convert::convert_poly_linestring_to_sf <std::string> (
         const std::vector <std::vector <std::string> > &id_vec, 
         const std::vector <std::string> &rel_id, const std::string type);
 
+/* SpPrototypes
+ *
+ * The 'new' calls here are the only R code evaluated in constructing sp
+ * geometries.
+ */
+osm_convert::SpPrototypes::SpPrototypes () :
+    m_line (Rcpp::Language ("new", "Line").eval ()),
+    m_lines (Rcpp::Language ("new", "Lines").eval ()),
+    m_polygon (Rcpp::Language ("new", "Polygon").eval ()),
+    m_polygons (Rcpp::Language ("new", "Polygons").eval ())
+{
+}
+
+Rcpp::S4 osm_convert::SpPrototypes::line (const Rcpp::NumericMatrix &coords) const
+{
+    Rcpp::S4 line (Rf_shallow_duplicate (m_line));
+    line.slot ("coords") = coords;
+    return line;
+}
+
+Rcpp::S4 osm_convert::SpPrototypes::lines (const Rcpp::List &line_list) const
+{
+    Rcpp::S4 lines (Rf_shallow_duplicate (m_lines));
+    lines.slot ("Lines") = line_list;
+    return lines;
+}
+
+/* Equivalent to 'sp::Polygon', including closing open rings and calculating
+ * the label point and area, but with 'hole' and 'ringDir' given explicitly.
+ */
+Rcpp::S4 osm_convert::SpPrototypes::polygon (Rcpp::NumericMatrix &coords,
+        const bool hole, const int ring_dir) const
+{
+    const int n = coords.nrow ();
+    if (n > 0 && (coords (0, 0) != coords (n - 1, 0) ||
+                coords (0, 1) != coords (n - 1, 1)))
+    {
+        Rcpp::NumericMatrix closed (Rcpp::Dimension (n + 1, 2));
+        for (int j = 0; j < 2; j++)
+        {
+            for (int i = 0; i < n; i++)
+                closed (i, j) = coords (i, j);
+            closed (n, j) = coords (0, j);
+        }
+        coords = closed;
+    }
+
+    double xc, yc;
+    const double area = std::fabs (ring_area_centroid (coords, xc, yc));
+
+    Rcpp::S4 poly (Rf_shallow_duplicate (m_polygon));
+    poly.slot ("coords") = coords;
+    poly.slot ("labpt") = Rcpp::NumericVector::create (xc, yc);
+    poly.slot ("area") = area;
+    poly.slot ("hole") = hole;
+    poly.slot ("ringDir") = ring_dir;
+    return poly;
+}
+
+/* Equivalent to 'new ("Polygons", ...)', with the label point of the largest
+ * outer ring, and the total area of all rings. The calling function fills
+ * 'ID' and 'plotOrder'.
+ */
+Rcpp::S4 osm_convert::SpPrototypes::polygons (
+        const Rcpp::List &polygon_list) const
+{
+    Rcpp::S4 polygons (Rf_shallow_duplicate (m_polygons));
+    polygons.slot ("Polygons") = polygon_list;
+
+    double area = 0.0, amax = -1.0;
+    Rcpp::NumericVector labpt (2, NA_REAL);
+    for (R_xlen_t i = 0; i < polygon_list.size (); i++)
+    {
+        const Rcpp::S4 poly (VECTOR_ELT (polygon_list, i));
+        const double a = Rcpp::as <double> (poly.slot ("area"));
+        area += a;
+        if (!Rcpp::as <bool> (poly.slot ("hole")) && a > amax)
+        {
+            amax = a;
+            labpt = Rcpp::NumericVector (poly.slot ("labpt"));
+        }
+    }
+    polygons.slot ("labpt") = labpt;
+    polygons.slot ("area") = area;
+    return polygons;
+}
+
+/* ring_area_centroid
+ *
+ * Signed area and centroid of a ring, by the same triangulation as 'sp', so
+ * that label points are identical. Centroids of rings with no area are the
+ * mid-points of their first and last coordinates.
+ *
+ * @param coords Two-column matrix of ring coordinates
+ * @param xc Set to x-coordinate of centroid
+ * @param yc Set to y-coordinate of centroid
+ *
+ * @return Signed area of ring, positive for anti-clockwise rings.
+ */
+double osm_convert::ring_area_centroid (const Rcpp::NumericMatrix &coords,
+        double &xc, double &yc)
+{
+    const int n = coords.nrow ();
+    if (n == 0)
+    {
+        xc = yc = NA_REAL;
+        return 0.0;
+    }
+
+    const double x0 = coords (0, 0), y0 = coords (0, 1);
+    double a2sum = 0.0, cx = 0.0, cy = 0.0;
+    for (int i = 1; i < n - 1; i++)
+    {
+        const double x1 = coords (i, 0), y1 = coords (i, 1),
+              x2 = coords (i + 1, 0), y2 = coords (i + 1, 1);
+        const double a2 = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+        cx += a2 * (x0 + x1 + x2);
+        cy += a2 * (y0 + y1 + y2);
+        a2sum += a2;
+    }
+    xc = cx / (3.0 * a2sum);
+    yc = cy / (3.0 * a2sum);
+    const double area = a2sum / 2.0;
+
+    if (std::fabs (area) < std::numeric_limits <double>::epsilon () &&
+            (!std::isfinite (xc) || !std::isfinite (yc)))
+    {
+        xc = (x0 + coords (n - 1, 0)) / 2.0;
+        yc = (y0 + coords (n - 1, 1)) / 2.0;
+    }
+
+    return area;
+}
+
 /* convert_multipoly_to_sp
  *
  * Converts the data contained in all the arguments into a
@@ -303,11 +703,10 @@ void osm_convert::convert_multipoly_to_sp (Rcpp::S4 &multipolygons, const Relati
         const string_arr3 &rowname_arr, const string_arr2 &id_vec,
         const UniqueVals &unique_vals)
 {
-    Rcpp::Environment sp_env = Rcpp::Environment::namespace_env ("sp");
-    Rcpp::Function Polygon = sp_env ["Polygon"];
-    Rcpp::Language polygons_call ("new", "Polygons");
+    const SpPrototypes proto;
 
-    size_t nrow = lon_arr.size (), ncol = unique_vals.k_rel.size ();
+    const KvColumns cols (unique_vals.k_rel_names, sp_reserved, false);
+    size_t nrow = lon_arr.size (), ncol = cols.ncol ();
     Rcpp::CharacterMatrix kv_mat (Rcpp::Dimension (nrow, ncol));
     std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
 
@@ -347,20 +746,13 @@ void osm_convert::convert_multipoly_to_sp (Rcpp::S4 &multipolygons, const Relati
                 //dimnames.erase (0, static_cast <int> (dimnames.size ()));
                 dimnames.erase (0, 2);
 
-                Rcpp::S4 poly = Polygon (nmat);
-                poly.slot ("hole") = !outer;
-                poly.slot ("ringDir") = static_cast <int> (1);
-                if (outer)
-                    outer = false;
-                else
-                    poly.slot ("ringDir") = static_cast <int> (-1);
-                outList_i [j] = poly;
+                outList_i [j] = proto.polygon (nmat, !outer, outer ? 1 : -1);
+                outer = false;
                 plotorder [j] = static_cast <int> (j) + 1; // 1-based R values
             }
             outList_i.attr ("names") = id_vec [i];
 
-            Rcpp::S4 polygons = polygons_call.eval ();
-            polygons.slot ("Polygons") = outList_i;
+            Rcpp::S4 polygons = proto.polygons (outList_i);
             // Issue #36 caused by data with one item having no actual data for
             // one item, so id_vec[i].size = lon_vec[i].size = ... = 0
             if (id_vec [i].size () > 0)
@@ -374,12 +766,10 @@ void osm_convert::convert_multipoly_to_sp (Rcpp::S4 &multipolygons, const Relati
             }
             //polygons.slot ("ID") = id_vec [i]; // sp expects char not vec!
             polygons.slot ("plotOrder") = plotorder;
-            //polygons.slot ("labpt") = poly.slot ("labpt");
-            //polygons.slot ("area") = poly.slot ("area");
             outList [i] = polygons;
             rel_id.push_back (std::to_string (itr->id));
 
-            osm_convert::get_value_mat_rel (itr, unique_vals, kv_mat, i++);
+            osm_convert::get_value_mat_rel (itr, unique_vals, cols, kv_mat, i++);
         } // end if ispoly & for i
     outList.attr ("names") = rel_id;
 
@@ -398,11 +788,8 @@ void osm_convert::convert_multipoly_to_sp (Rcpp::S4 &multipolygons, const Relati
     Rcpp::DataFrame kv_df = R_NilValue;
     if (rel_id.size () > 0)
     {
-        kv_mat.attr ("names") = unique_vals.k_rel;
-        kv_mat.attr ("dimnames") = Rcpp::List::create (rel_id, unique_vals.k_rel);
-        kv_mat.attr ("names") = unique_vals.k_rel;
-        if (kv_mat.nrow () > 0 && kv_mat.ncol () > 0)
-            kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
+        kv_mat.attr ("dimnames") = Rcpp::List::create (rel_id, cols.names ());
+        kv_df = kv_mat;
         multipolygons.slot ("data") = kv_df;
     }
     rel_id.clear ();
@@ -427,9 +814,7 @@ void osm_convert::convert_multiline_to_sp (Rcpp::S4 &multilines, const Relations
         const string_arr3 &rowname_arr, const osmt_arr2 &id_vec,
         const UniqueVals &unique_vals)
 {
-
-    Rcpp::Language line_call ("new", "Line");
-    Rcpp::Language lines_call ("new", "Lines");
+    const SpPrototypes proto;
 
     Rcpp::NumericMatrix nmat (Rcpp::Dimension (0, 0));
     Rcpp::List dimnames (0);
@@ -442,7 +827,9 @@ void osm_convert::convert_multiline_to_sp (Rcpp::S4 &multilines, const Relations
     rel_id.reserve (nlines);
 
     Rcpp::List outList (nlines); 
-    size_t ncol = unique_vals.k_rel.size ();
+    // One row for each relation, so no roles
+    const KvColumns cols (unique_vals.k_rel_names, sp_reserved, false);
+    size_t ncol = cols.ncol ();
     Rcpp::CharacterMatrix kv_mat (Rcpp::Dimension (nlines, ncol));
     std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
 
@@ -466,20 +853,16 @@ void osm_convert::convert_multiline_to_sp (Rcpp::S4 &multilines, const Relations
                 //dimnames.erase (0, static_cast <int> (dimnames.size ()));
                 dimnames.erase (0, 2);
 
-                Rcpp::S4 line = line_call.eval ();
-                line.slot ("coords") = nmat;
-
-                outList_i [j] = line;
+                outList_i [j] = proto.line (nmat);
             }
             outList_i.attr ("names") = id_vec [i]; // implicit type conversion
-            Rcpp::S4 lines = lines_call.eval ();
-            lines.slot ("Lines") = outList_i;
+            Rcpp::S4 lines = proto.lines (outList_i);
             lines.slot ("ID") = itr->id;
 
             outList [i] = lines;
             rel_id.push_back (std::to_string (itr->id));
 
-            osm_convert::get_value_mat_rel (itr, unique_vals, kv_mat, i++);
+            osm_convert::get_value_mat_rel (itr, unique_vals, cols, kv_mat, i++);
         } // end if ispoly & for i
     outList.attr ("names") = rel_id;
 
@@ -490,70 +873,171 @@ void osm_convert::convert_multiline_to_sp (Rcpp::S4 &multilines, const Relations
     Rcpp::DataFrame kv_df = R_NilValue;
     if (rel_id.size () > 0)
     {
-        kv_mat.attr ("names") = unique_vals.k_rel;
-        kv_mat.attr ("dimnames") = Rcpp::List::create (rel_id, unique_vals.k_rel);
-        kv_mat.attr ("names") = unique_vals.k_rel;
-        if (kv_mat.nrow () > 0 && kv_mat.ncol () > 0)
-            kv_df = osm_convert::restructure_kv_mat (kv_mat, true);
+        kv_mat.attr ("dimnames") = Rcpp::List::create (rel_id, cols.names ());
+        kv_df = kv_mat;
         multilines.slot ("data") = kv_df;
     }
     rel_id.clear ();
 }
 
-/* convert_relation_to_sc
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **              FUNCTIONS TO CONVERT C++ OBJECTS TO WKB               **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+/* These write geometries directly as OGC Well-Known Binary (WKB) into
+ * pre-allocated Rcpp::RawVector objects, for conversion in R with
+ * 'sf::st_as_sfc'. This avoids constructing nested lists of matrices with
+ * class and dimnames attributes for each geometry. Values are written in
+ * native byte order, which is flagged in the first byte of each geometry as
+ * required by the standard.
+ */
+
+unsigned char * osm_convert::wkb_put_header (unsigned char *p,
+        const wkb_type type)
+{
+    const uint16_t one = 1;
+    // 1 = little endian (NDR); 0 = big endian (XDR)
+    *p++ = *reinterpret_cast <const unsigned char *> (&one);
+    return wkb_put_uint32 (p, static_cast <uint32_t> (type));
+}
+
+unsigned char * osm_convert::wkb_put_uint32 (unsigned char *p,
+        const uint32_t n)
+{
+    std::memcpy (p, &n, sizeof (uint32_t));
+    return p + sizeof (uint32_t);
+}
+
+unsigned char * osm_convert::wkb_put_xy (unsigned char *p,
+        const double x, const double y)
+{
+    std::memcpy (p, &x, sizeof (double));
+    std::memcpy (p + sizeof (double), &y, sizeof (double));
+    return p + 2 * sizeof (double);
+}
+
+/* WKB sizes in bytes of headers (byte order + type), counts, and points */
+const size_t wkb_nhead = 1 + sizeof (uint32_t), wkb_ncount = sizeof (uint32_t),
+      wkb_nxy = 2 * sizeof (double);
+
+/* wkb_point
  *
- * Converts the data contained in all the arguments into an SC object
+ * @param lon Longitude of point
+ * @param lat Latitude of point
+ * @return Rcpp::RawVector holding WKB POINT
+ */
+Rcpp::RawVector osm_convert::wkb_point (const double lon, const double lat)
+{
+    Rcpp::RawVector res (wkb_nhead + wkb_nxy);
+    unsigned char *p = res.begin ();
+    p = wkb_put_header (p, wkb_type::point);
+    wkb_put_xy (p, lon, lat);
+
+    return res;
+}
+
+/* wkb_way
  *
- * @param id_vec 2D array of either <std::string> or <osmid_t> IDs for all ways
- *        used in the geometry.
+ * Equivalent of 'trace_way_nmat' for WKB output.
  *
- * @return Objects pointed to by 'members_out' and 'kv_out' are constructed.
+ * @param wayi Constant iterator to one OSM way
+ * @param &nodes pointer to Nodes structure
+ * @param polygon If true, write a POLYGON with a single ring, otherwise a
+ *        LINESTRING
+ * @return Rcpp::RawVector holding WKB geometry
  */
-void osm_convert::convert_relation_to_sc (string_arr2 &members_out,
-        string_arr2 &kv_out, const Relations &rels,
-        const UniqueVals &unique_vals)
+Rcpp::RawVector osm_convert::wkb_way (Ways::const_iterator wayi,
+        const Nodes &nodes, const bool polygon)
 {
-    size_t nmembers = 0;
-    for (auto itr = rels.begin (); itr != rels.end (); itr++)
-        nmembers += itr->relations.size ();
+    const std::vector <osmid_t> &way_nodes = wayi->second.nodes;
+    const size_t n = way_nodes.size ();
+    size_t nbytes = wkb_nhead + wkb_ncount + n * wkb_nxy;
+    if (polygon)
+        nbytes += wkb_ncount;
 
-    members_out.resize (nmembers);
-    for (auto m: members_out)
-        m.resize (3);
-
-    size_t ncol = unique_vals.k_rel.size ();
-    kv_out.resize (ncol);
-    for (auto k: kv_out)
-        k.resize (rels.size ());
+    Rcpp::RawVector res (nbytes);
+    unsigned char *p = res.begin ();
+    if (polygon)
+    {
+        p = wkb_put_header (p, wkb_type::polygon);
+        p = wkb_put_uint32 (p, 1);
+    } else
+        p = wkb_put_header (p, wkb_type::linestring);
+    p = wkb_put_uint32 (p, static_cast <uint32_t> (n));
 
-    unsigned int rowi = 0; // explicit loop index - see note at top of osmdata-sf
-    for (auto itr = rels.begin (); itr != rels.end (); itr++)
+    for (auto ni: way_nodes)
     {
-        //const unsigned int rowi = static_cast <unsigned int> (
-        //        std::distance (rels.begin (), itr));
+        auto nd = nodes.find (ni);
+        p = wkb_put_xy (p, nd->second.lon, nd->second.lat);
+    }
+
+    return res;
+}
 
-        // Get all members of that relation and their roles:
-        unsigned int rowj = rowi;
-        for (auto ritr = itr->relations.begin ();
-                ritr != itr->relations.end (); ++ritr)
+/* convert_poly_linestring_to_wkb
+ *
+ * Equivalent of 'convert_poly_linestring_to_sf' for WKB output. As for that
+ * function, all rings of a multipolygon relation are written as a single
+ * polygon.
+ *
+ * @param lon_arr 3D array of longitudinal coordinates
+ * @param lat_arr 3D array of latgitudinal coordinates
+ * @param rel_id Vector of <osmid_t> IDs for each relation.
+ * @param type Either "MULTILINESTRING" or "MULTIPOLYGON"
+ *
+ * @return An Rcpp::List of Rcpp::RawVector objects, one for each relation.
+ */
+Rcpp::List osm_convert::convert_poly_linestring_to_wkb (
+        const double_arr3 &lon_arr, const double_arr3 &lat_arr,
+        const std::vector <std::string> &rel_id, const std::string type)
+{
+    if (!(type == "MULTILINESTRING" || type == "MULTIPOLYGON"))
+        throw std::runtime_error ("type must be multilinestring/polygon"); // # nocov
+    const bool mp = (type == "MULTIPOLYGON");
+
+    Rcpp::List outList (lon_arr.size ());
+    for (size_t i = 0; i < lon_arr.size (); i++) // over all relations
+    {
+        // multilinestrings have a header for each linestring; multipolygons
+        // have one polygon header, plus a count for each ring
+        size_t nbytes = wkb_nhead + wkb_ncount;
+        if (mp)
+            nbytes += wkb_nhead + wkb_ncount;
+        for (size_t j = 0; j < lon_arr [i].size (); j++)
         {
-            //const unsigned int rowj = rowi + static_cast <unsigned int> (
-            //        std::distance (itr->relations.begin (), ritr));
-            members_out [rowj] [0] = std::to_string (itr->id);
-            members_out [rowj] [1] = std::to_string (ritr->first); // OSM id
-            members_out [rowj++] [2] = ritr->second; // role
+            nbytes += wkb_ncount + lon_arr [i][j].size () * wkb_nxy;
+            if (!mp)
+                nbytes += wkb_nhead;
         }
-        
-        // And then key-value pairs
-        for (auto kv_iter = itr->key_val.begin ();
-                kv_iter != itr->key_val.end (); ++kv_iter)
+
+        Rcpp::RawVector res (nbytes);
+        unsigned char *p = res.begin ();
+        const uint32_t nparts = static_cast <uint32_t> (lon_arr [i].size ());
+        if (mp)
+        {
+            p = wkb_put_header (p, wkb_type::multipolygon);
+            p = wkb_put_uint32 (p, 1);
+            p = wkb_put_header (p, wkb_type::polygon);
+        } else
+            p = wkb_put_header (p, wkb_type::multilinestring);
+        p = wkb_put_uint32 (p, nparts);
+
+        for (size_t j = 0; j < lon_arr [i].size (); j++) // over all ways
         {
-            const std::string &key = kv_iter->first;
-            //long int coli = static_cast <long int> (
-            //        unique_vals.k_rel_index.at (key));
-            unsigned int coli = unique_vals.k_rel_index.at (key);
-            kv_out [coli] [rowi] = kv_iter->second;
+            if (!mp)
+                p = wkb_put_header (p, wkb_type::linestring);
+            const size_t n = lon_arr [i][j].size ();
+            p = wkb_put_uint32 (p, static_cast <uint32_t> (n));
+            for (size_t k = 0; k < n; k++)
+                p = wkb_put_xy (p, lon_arr [i][j][k], lat_arr [i][j][k]);
         }
-        rowi++;
-    } // end for itr
+        outList [i] = res;
+    }
+    outList.attr ("names") = rel_id;
+
+    return outList;
 }
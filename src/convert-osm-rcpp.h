@@ -33,22 +33,107 @@
 
 #include "common.h"
 
+#include <cstdint>
+
 #include <Rcpp.h>
 
 namespace osm_convert {
 
-void trace_way_nmat (const Ways &ways, const Nodes &nodes, 
-        const osmid_t &wayi_id, Rcpp::NumericMatrix &nmat);
+void trace_way_nmat (Ways::const_iterator wayi, const Nodes &nodes,
+        Rcpp::NumericMatrix &nmat);
+
+// Names of columns other than keys in each output. Key-value data of 'sf'
+// objects are combined in R with metadata and geometry columns, and those of
+// multilinestrings also have a "role" column.
+typedef std::unordered_set <std::string> ReservedNames;
+extern const ReservedNames sf_reserved, sf_reserved_ls, sp_reserved;
+
+std::vector <std::string> rename_reserved (const std::vector <std::string> &keys,
+        const ReservedNames &reserved, std::set <std::string> &renamed);
+
+/* Columns of the key-value matrices of 'sf' and 'sp' objects, which are
+ * "osm_id", then "name" where present, then "role" for multilinestrings,
+ * followed by all other keys. Keys are indexed with any "name" first, so each
+ * column is the index of the key offset by the preceding columns, and matrices
+ * are allocated once in their final form. */
+struct KvColumns
+{
+    const std::vector <std::string> &keys;
+    const ReservedNames &reserved;
+    const bool has_name, ls;
+
+    KvColumns (const std::vector <std::string> &k, const ReservedNames &r,
+            const bool roles) :
+        keys (k), reserved (r), has_name (!k.empty () && k [0] == "name"),
+        ls (roles) {}
+
+    size_t ncol () const { return keys.size () + (ls ? 2 : 1); }
+    size_t role () const { return has_name ? 2 : 1; }
+    // Column of the key at index 'i' of 'keys'
+    size_t col (const unsigned int i) const
+    {
+        return i + ((ls && !(has_name && i == 0)) ? 2 : 1);
+    }
+
+    Rcpp::CharacterVector names () const;
+};
 
 void get_value_mat_way (Ways::const_iterator wayi,
-        const UniqueVals &unique_vals, Rcpp::CharacterMatrix &value_arr,
-        unsigned int rowi);
+        const UniqueVals &unique_vals, const KvColumns &cols,
+        Rcpp::CharacterMatrix &value_arr, unsigned int rowi);
 
 void get_value_mat_rel (Relations::const_iterator &reli,
-        const UniqueVals &unique_vals, Rcpp::CharacterMatrix &value_arr,
-        unsigned int rowi);
+        const UniqueVals &unique_vals, const KvColumns &cols,
+        Rcpp::CharacterMatrix &value_arr, unsigned int rowi);
+
+void ids_to_numeric (SEXP df, const bool int64);
+
+SEXP as_factor (const Rcpp::CharacterVector &x, const size_t max_levels);
+void factorise_columns (SEXP df, const int max_levels);
+
+// Unit suffixes of tag values, and the factors by which they multiply values
+typedef std::vector <std::pair <std::string, double> > UnitRules;
+
+UnitRules unit_rules (const Rcpp::NumericVector &units);
+SEXP as_typed (const Rcpp::CharacterVector &x, const UnitRules &units);
+void type_columns (SEXP df, const UnitRules &units);
+
+// OSM data are always UTF-8, so strings are marked as such when they are
+// created, and need no conversion in R.
+inline SEXP mkchar_utf8 (const std::string &s)
+{
+    return Rf_mkCharLenCE (s.c_str (), static_cast <int> (s.size ()), CE_UTF8);
+}
 
-Rcpp::CharacterMatrix restructure_kv_mat (Rcpp::CharacterMatrix &kv, bool ls);
+inline void set_utf8 (Rcpp::CharacterVector &x, const R_xlen_t i,
+        const std::string &s)
+{
+    SET_STRING_ELT (x, i, mkchar_utf8 (s));
+}
+
+inline void set_utf8 (Rcpp::CharacterMatrix &x, const size_t row,
+        const size_t col, const std::string &s)
+{
+    SET_STRING_ELT (x, static_cast <R_xlen_t> (row + static_cast <size_t> (
+                    x.nrow ()) * col), mkchar_utf8 (s));
+}
+
+inline Rcpp::CharacterVector utf8_vector (const std::vector <std::string> &s)
+{
+    Rcpp::CharacterVector x (s.size ());
+    for (size_t i = 0; i < s.size (); i++)
+        set_utf8 (x, static_cast <R_xlen_t> (i), s [i]);
+    return x;
+}
+
+// Keys which share the column of another key only fill cells in which that
+// key has no value (see XmlData::make_key_val_indices).
+inline bool keep_value (const UniqueVals &unique_vals, const std::string &key,
+        SEXP cell)
+{
+    return unique_vals.k_merged.empty () || cell == NA_STRING ||
+        unique_vals.k_merged.count (key) == 0;
+}
 
 template <typename T> Rcpp::List convert_poly_linestring_to_sf (
         const double_arr3 &lon_arr, const double_arr3 &lat_arr, 
@@ -66,8 +151,45 @@ void convert_multiline_to_sp (Rcpp::S4 &multilines, const Relations &rels,
         const string_arr3 &rowname_arr, const osmt_arr2 &id_vec,
         const UniqueVals &unique_vals);
 
-void convert_relation_to_sc (string_arr2 &members_out,
-        string_arr2 &kv_out, const Relations &rels,
-        const UniqueVals &unique_vals);
+// Prototypes of the sp classes used for each geometry, each created only once
+// with 'new'. Objects are then shallow copies of these with slots filled
+// directly, so no R code (and no S4 dispatch) is evaluated within loops over
+// geometries.
+class SpPrototypes
+{
+    private:
+        Rcpp::S4 m_line, m_lines, m_polygon, m_polygons;
+
+    public:
+        SpPrototypes ();
+
+        Rcpp::S4 line (const Rcpp::NumericMatrix &coords) const;
+        Rcpp::S4 lines (const Rcpp::List &line_list) const;
+        Rcpp::S4 polygon (Rcpp::NumericMatrix &coords, const bool hole,
+                const int ring_dir) const;
+        Rcpp::S4 polygons (const Rcpp::List &polygon_list) const;
+};
+
+double ring_area_centroid (const Rcpp::NumericMatrix &coords, double &xc,
+        double &yc);
+
+// Well-Known Binary (WKB) output, as an alternative to sfg objects
+enum class wkb_type : uint32_t {
+    point = 1, linestring = 2, polygon = 3, multilinestring = 5,
+    multipolygon = 6
+};
+
+unsigned char * wkb_put_header (unsigned char *p, const wkb_type type);
+unsigned char * wkb_put_uint32 (unsigned char *p, const uint32_t n);
+unsigned char * wkb_put_xy (unsigned char *p, const double x, const double y);
+
+Rcpp::RawVector wkb_point (const double lon, const double lat);
+
+Rcpp::RawVector wkb_way (Ways::const_iterator wayi, const Nodes &nodes,
+        const bool polygon);
+
+Rcpp::List convert_poly_linestring_to_wkb (const double_arr3 &lon_arr,
+        const double_arr3 &lat_arr, const std::vector <std::string> &rel_id,
+        const std::string type);
 
 } // end namespace osm_convert
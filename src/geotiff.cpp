@@ -0,0 +1,498 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       geotiff.cpp
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osm-router.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Minimal memory-mapped reader of single-band GeoTIFF
+ *                  rasters, such as SRTM elevation tiles.
+ *
+ *  Limitations:    See geotiff.h
+ *
+ *  Dependencies:       none
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#include "geotiff.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace geotiff {
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                            MAPPED FILES                            **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+MappedFile::MappedFile (const std::string &path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA (path.c_str (), GENERIC_READ, FILE_SHARE_READ,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER size;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx (file, &size) && size.QuadPart > 0)
+            mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0,
+                    nullptr);
+        if (mapping != nullptr)
+        {
+            void *view = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view != nullptr)
+            {
+                m_data = static_cast <const uint8_t *> (view);
+                m_size = static_cast <size_t> (size.QuadPart);
+                m_mapped = true;
+                m_file = file;
+                m_mapping = mapping;
+                return;
+            }
+            CloseHandle (mapping);
+        }
+        CloseHandle (file);
+    }
+#else
+    const int fd = open (path.c_str (), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (fstat (fd, &st) == 0 && st.st_size > 0)
+        {
+            void *addr = mmap (nullptr, static_cast <size_t> (st.st_size),
+                    PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                m_data = static_cast <const uint8_t *> (addr);
+                m_size = static_cast <size_t> (st.st_size);
+                m_mapped = true;
+            }
+        }
+        close (fd); // mapping remains valid after closing
+        if (m_mapped)
+            return;
+    }
+#endif
+
+    std::ifstream in (path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error ("unable to open file " + path);
+    m_buffer.assign (std::istreambuf_iterator <char> (in),
+            std::istreambuf_iterator <char> ());
+    m_data = m_buffer.data ();
+    m_size = m_buffer.size ();
+}
+
+MappedFile::~MappedFile ()
+{
+    if (!m_mapped)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile (m_data);
+    CloseHandle (m_mapping);
+    CloseHandle (m_file);
+#else
+    munmap (const_cast <uint8_t *> (m_data), m_size);
+#endif
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                               RASTERS                              **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+namespace {
+
+// TIFF tags used here
+const uint16_t TAG_WIDTH = 256, TAG_HEIGHT = 257, TAG_BITS = 258,
+      TAG_COMPRESSION = 259, TAG_STRIP_OFFSETS = 273, TAG_SAMPLES = 277,
+      TAG_ROWS_PER_STRIP = 278, TAG_TILE_WIDTH = 322, TAG_TILE_HEIGHT = 323,
+      TAG_TILE_OFFSETS = 324, TAG_SAMPLE_FORMAT = 339,
+      TAG_PIXEL_SCALE = 33550, TAG_TIEPOINT = 33922, TAG_GEOKEYS = 34735,
+      TAG_NODATA = 42113;
+
+const uint16_t GEOKEY_RASTER_TYPE = 1025, RASTER_PIXEL_IS_POINT = 2;
+
+// Sizes in bytes of TIFF field types, indexed by type code
+size_t type_size (const uint16_t type)
+{
+    switch (type)
+    {
+        case 1: case 2: case 6: case 7: return 1; // byte, ascii, sbyte, undef
+        case 3: case 8: return 2; // short, sshort
+        case 4: case 9: case 11: case 13: return 4; // long, slong, float, ifd
+        case 5: case 10: case 12: case 16: case 17: case 18: return 8;
+        default: return 0;
+    }
+}
+
+bool host_is_little_endian ()
+{
+    const uint16_t one = 1;
+    uint8_t first;
+    std::memcpy (&first, &one, 1);
+    return first == 1;
+}
+
+struct Field
+{
+    uint16_t type = 0;
+    uint64_t count = 0;
+    size_t pos = 0; // position of first value in file
+};
+
+} // end anonymous namespace
+
+uint64_t Raster::read_uint (const size_t pos, const size_t nbytes) const
+{
+    if (pos + nbytes > m_file.size ())
+        throw std::runtime_error ("GeoTIFF file is truncated");
+
+    const uint8_t *p = m_file.data () + pos;
+    uint64_t val = 0;
+    const bool little = host_is_little_endian () != m_swap;
+    for (size_t i = 0; i < nbytes; i++)
+    {
+        const size_t shift = little ? i : nbytes - 1 - i;
+        val |= static_cast <uint64_t> (p [i]) << (8 * shift);
+    }
+    return val;
+}
+
+double Raster::read_sample (const size_t pos) const
+{
+    const uint64_t bits = read_uint (pos, m_bytes);
+    if (m_sample_format == 3)
+    {
+        if (m_bytes == 4)
+        {
+            const uint32_t b32 = static_cast <uint32_t> (bits);
+            float f;
+            std::memcpy (&f, &b32, 4);
+            return static_cast <double> (f);
+        }
+        double d;
+        std::memcpy (&d, &bits, 8);
+        return d;
+    }
+    if (m_sample_format == 2) // sign-extend
+    {
+        const size_t shift = 64 - 8 * m_bytes;
+        return static_cast <double> (
+                static_cast <int64_t> (bits << shift) >> shift);
+    }
+    return static_cast <double> (bits);
+}
+
+// Reads the first image file directory, which holds the full-resolution image
+// in GeoTIFF files. Both classic TIFF and BigTIFF are supported.
+void Raster::read_ifd ()
+{
+    const uint8_t *data = m_file.data ();
+    if (m_file.size () < 16)
+        throw std::runtime_error ("file is not a TIFF file");
+
+    if (data [0] == 'I' && data [1] == 'I')
+        m_swap = !host_is_little_endian ();
+    else if (data [0] == 'M' && data [1] == 'M')
+        m_swap = host_is_little_endian ();
+    else
+        throw std::runtime_error ("file is not a TIFF file");
+
+    const uint64_t version = read_uint (2, 2);
+    if (version != 42 && version != 43)
+        throw std::runtime_error ("file is not a TIFF file");
+    const bool big = version == 43;
+    const size_t offset_size = big ? 8 : 4;
+
+    size_t pos = static_cast <size_t> (big ? read_uint (8, 8) :
+            read_uint (4, 4));
+    const uint64_t n_entries = read_uint (pos, big ? 8 : 2);
+    pos += big ? 8 : 2;
+
+    std::vector <std::pair <uint16_t, Field> > fields;
+    for (uint64_t i = 0; i < n_entries; i++)
+    {
+        Field f;
+        const uint16_t tag = static_cast <uint16_t> (read_uint (pos, 2));
+        f.type = static_cast <uint16_t> (read_uint (pos + 2, 2));
+        f.count = read_uint (pos + 4, offset_size);
+        const size_t value_pos = pos + 4 + offset_size;
+        if (f.count * type_size (f.type) <= offset_size)
+            f.pos = value_pos;
+        else
+            f.pos = static_cast <size_t> (read_uint (value_pos, offset_size));
+        fields.push_back (std::make_pair (tag, f));
+        pos += 4 + 2 * offset_size;
+    }
+
+    auto find_field = [&fields] (const uint16_t tag, Field &f) -> bool {
+        for (auto fi: fields)
+            if (fi.first == tag)
+            {
+                f = fi.second;
+                return true;
+            }
+        return false;
+    };
+    auto uints = [this] (const Field &f) -> std::vector <uint64_t> {
+        const size_t s = type_size (f.type);
+        std::vector <uint64_t> res (f.count);
+        for (size_t i = 0; i < f.count; i++)
+            res [i] = read_uint (f.pos + i * s, s);
+        return res;
+    };
+    auto doubles = [this] (const Field &f) -> std::vector <double> {
+        std::vector <double> res (f.count);
+        for (size_t i = 0; i < f.count; i++)
+        {
+            const uint64_t bits = read_uint (f.pos + i * 8, 8);
+            std::memcpy (&res [i], &bits, 8);
+        }
+        return res;
+    };
+    auto uint_or = [&] (const uint16_t tag, const uint64_t dflt) -> uint64_t {
+        Field f;
+        if (!find_field (tag, f) || f.count == 0)
+            return dflt;
+        return uints (f) [0];
+    };
+
+    width = static_cast <size_t> (uint_or (TAG_WIDTH, 0));
+    height = static_cast <size_t> (uint_or (TAG_HEIGHT, 0));
+    if (width == 0 || height == 0)
+        throw std::runtime_error ("GeoTIFF file has no image data");
+
+    if (uint_or (TAG_COMPRESSION, 1) != 1)
+        throw std::runtime_error ("only uncompressed GeoTIFF files are "
+                "supported; files may be converted with "
+                "'gdal_translate -co COMPRESS=NONE'");
+    if (uint_or (TAG_SAMPLES, 1) != 1)
+        throw std::runtime_error ("only single-band GeoTIFF files are "
+                "supported");
+
+    const uint64_t bits = uint_or (TAG_BITS, 1);
+    m_sample_format = static_cast <int> (uint_or (TAG_SAMPLE_FORMAT, 1));
+    if ((bits != 8 && bits != 16 && bits != 32 && bits != 64) ||
+            m_sample_format < 1 || m_sample_format > 3 ||
+            (m_sample_format == 3 && bits < 32))
+        throw std::runtime_error ("unsupported data type in GeoTIFF file");
+    m_bytes = static_cast <size_t> (bits / 8);
+
+    Field f;
+    if (find_field (TAG_TILE_OFFSETS, f))
+    {
+        m_tiled = true;
+        m_block_width = static_cast <size_t> (uint_or (TAG_TILE_WIDTH, 0));
+        m_block_height = static_cast <size_t> (uint_or (TAG_TILE_HEIGHT, 0));
+    } else if (find_field (TAG_STRIP_OFFSETS, f))
+    {
+        m_block_width = width;
+        m_block_height = static_cast <size_t> (
+                uint_or (TAG_ROWS_PER_STRIP, height));
+        m_block_height = std::min (m_block_height, height);
+    } else
+        throw std::runtime_error ("GeoTIFF file has no image data");
+    if (m_block_width == 0 || m_block_height == 0)
+        throw std::runtime_error ("GeoTIFF file has invalid block sizes");
+    m_blocks_across = (width + m_block_width - 1) / m_block_width;
+    m_block_offsets = uints (f);
+    const size_t n_blocks = m_blocks_across *
+        ((height + m_block_height - 1) / m_block_height);
+    if (m_block_offsets.size () < n_blocks)
+        throw std::runtime_error ("GeoTIFF file has too few data blocks");
+
+    Field fscale, ftie;
+    if (!find_field (TAG_PIXEL_SCALE, fscale) || fscale.count < 2 ||
+            !find_field (TAG_TIEPOINT, ftie) || ftie.count < 6)
+        throw std::runtime_error ("GeoTIFF file has no georeferencing; only "
+                "ModelPixelScale and ModelTiepoint tags are supported");
+    const std::vector <double> scale = doubles (fscale),
+          tie = doubles (ftie);
+    dx = scale [0];
+    dy = scale [1];
+    x0 = tie [3] - tie [0] * dx;
+    y0 = tie [4] + tie [1] * dy;
+
+    // Tiepoints refer to pixel centres rather than corners for PixelIsPoint
+    if (find_field (TAG_GEOKEYS, f) && f.count >= 4)
+    {
+        const std::vector <uint64_t> keys = uints (f);
+        for (size_t i = 4; i + 3 < keys.size (); i += 4)
+            if (keys [i] == GEOKEY_RASTER_TYPE && keys [i + 1] == 0 &&
+                    keys [i + 3] == RASTER_PIXEL_IS_POINT)
+            {
+                x0 -= dx / 2.0;
+                y0 += dy / 2.0;
+            }
+    }
+
+    if (find_field (TAG_NODATA, f) && f.count > 0 &&
+            f.pos + f.count <= m_file.size ())
+    {
+        const std::string s (reinterpret_cast <const char *> (data + f.pos),
+                static_cast <size_t> (f.count));
+        char *end;
+        m_nodata = std::strtod (s.c_str (), &end);
+        m_has_nodata = end != s.c_str ();
+    }
+}
+
+Raster::Raster (const std::string &path) : m_file (path)
+{
+    try
+    {
+        read_ifd ();
+    } catch (std::exception &e)
+    {
+        throw std::runtime_error (path + ": " + e.what ());
+    }
+}
+
+bool Raster::contains (const double x, const double y) const
+{
+    return x >= xmin () && x < xmax () && y > ymin () && y <= ymax ();
+}
+
+double Raster::pixel (const long col, const long row) const
+{
+    const double nan = std::numeric_limits <double>::quiet_NaN ();
+    if (col < 0 || row < 0 || static_cast <size_t> (col) >= width ||
+            static_cast <size_t> (row) >= height)
+        return nan;
+
+    const size_t c = static_cast <size_t> (col),
+          r = static_cast <size_t> (row);
+    const size_t block = (r / m_block_height) * m_blocks_across +
+        c / m_block_width;
+    const size_t index = (r % m_block_height) * m_block_width +
+        c % m_block_width;
+    const size_t pos = static_cast <size_t> (m_block_offsets [block]) +
+        index * m_bytes;
+    if (pos + m_bytes > m_file.size ())
+        return nan;
+
+    const double val = read_sample (pos);
+    if (m_has_nodata && val == m_nodata)
+        return nan;
+    return val;
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                               MOSAICS                              **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+Mosaic::Mosaic (const std::vector <std::string> &files)
+{
+    for (auto f: files)
+        m_rasters.push_back (std::unique_ptr <Raster> (new Raster (f)));
+}
+
+long Mosaic::find (const double x, const double y) const
+{
+    if (m_last < m_rasters.size () && m_rasters [m_last]->contains (x, y))
+        return static_cast <long> (m_last);
+    for (size_t i = 0; i < m_rasters.size (); i++)
+        if (m_rasters [i]->contains (x, y))
+        {
+            m_last = i;
+            return static_cast <long> (i);
+        }
+    return -1L;
+}
+
+double Mosaic::nearest (const double x, const double y) const
+{
+    const long i = find (x, y);
+    if (i < 0)
+        return std::numeric_limits <double>::quiet_NaN ();
+    const Raster &r = *m_rasters [static_cast <size_t> (i)];
+    return r.pixel (static_cast <long> (std::floor ((x - r.x0) / r.dx)),
+            static_cast <long> (std::floor ((r.y0 - y) / r.dy)));
+}
+
+double Mosaic::bilinear (const double x, const double y) const
+{
+    const long i = find (x, y);
+    if (i < 0)
+        return std::numeric_limits <double>::quiet_NaN ();
+    const Raster &r = *m_rasters [static_cast <size_t> (i)];
+
+    // Fractional pixel positions relative to pixel centres
+    const double fc = (x - r.x0) / r.dx - 0.5, fr = (r.y0 - y) / r.dy - 0.5;
+    const long c0 = static_cast <long> (std::floor (fc)),
+          r0 = static_cast <long> (std::floor (fr));
+    const double wc = fc - c0, wr = fr - r0;
+
+    double sum = 0.0, wsum = 0.0;
+    for (long j = 0; j < 2; j++)
+        for (long k = 0; k < 2; k++)
+        {
+            const long col = c0 + k, row = r0 + j;
+            double val = r.pixel (col, row);
+            if (std::isnan (val) && (col < 0 || row < 0 ||
+                    static_cast <size_t> (col) >= r.width ||
+                    static_cast <size_t> (row) >= r.height))
+            {
+                // Neighbouring pixel lies in an adjacent raster
+                val = nearest (r.x0 + (col + 0.5) * r.dx,
+                        r.y0 - (row + 0.5) * r.dy);
+            }
+            if (std::isnan (val))
+                continue;
+            const double w = (k == 0 ? 1.0 - wc : wc) *
+                (j == 0 ? 1.0 - wr : wr);
+            sum += w * val;
+            wsum += w;
+        }
+
+    if (wsum <= 0.0)
+        return std::numeric_limits <double>::quiet_NaN ();
+    return sum / wsum;
+}
+
+} // end namespace geotiff
@@ -0,0 +1,130 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       geotiff.h
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osm-router.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Minimal memory-mapped reader of single-band GeoTIFF
+ *                  rasters, such as SRTM elevation tiles (no Rcpp here, and
+ *                  no dependency on GDAL or libtiff).
+ *
+ *  Limitations:    Only uncompressed rasters with one sample per pixel are
+ *                  supported, in either strips or tiles, of 8-, 16-, 32-, or
+ *                  64-bit integer or floating point values. Georeferencing
+ *                  must be given by ModelPixelScale and ModelTiepoint tags
+ *                  (no rotation or ModelTransformation).
+ *
+ *  Dependencies:       none
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace geotiff {
+
+/* Read-only view of a whole file. The file is memory-mapped where possible, so
+ * that only those pages which are actually accessed are ever read from disk.
+ * If mapping fails, the file is read into memory instead. */
+class MappedFile
+{
+    private:
+        const uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+        bool m_mapped = false;
+        std::vector <uint8_t> m_buffer;
+#ifdef _WIN32
+        void *m_file = nullptr, *m_mapping = nullptr;
+#endif
+
+    public:
+        MappedFile (const std::string &path);
+        ~MappedFile ();
+        MappedFile (const MappedFile &) = delete;
+        MappedFile &operator= (const MappedFile &) = delete;
+
+        const uint8_t *data () const { return m_data; }
+        size_t size () const { return m_size; }
+};
+
+class Raster
+{
+    private:
+        MappedFile m_file;
+        bool m_swap = false; // byte order of file differs from host
+        bool m_tiled = false;
+        int m_sample_format = 1; // 1 = unsigned, 2 = signed, 3 = float
+        size_t m_bytes = 0; // per sample
+        size_t m_block_width = 0, m_block_height = 0, m_blocks_across = 0;
+        std::vector <uint64_t> m_block_offsets;
+
+        bool m_has_nodata = false;
+        double m_nodata = 0.0;
+
+        void read_ifd ();
+        uint64_t read_uint (const size_t pos, const size_t nbytes) const;
+        double read_sample (const size_t pos) const;
+
+    public:
+        size_t width = 0, height = 0;
+        // Coordinates of the outer corner of pixel (0, 0), and pixel sizes
+        double x0 = 0.0, y0 = 0.0, dx = 1.0, dy = 1.0;
+
+        Raster (const std::string &path);
+
+        double xmin () const { return x0; }
+        double xmax () const { return x0 + dx * width; }
+        double ymin () const { return y0 - dy * height; }
+        double ymax () const { return y0; }
+        bool contains (const double x, const double y) const;
+
+        // Value of one pixel, or NaN for no data or pixels beyond the raster
+        double pixel (const long col, const long row) const;
+};
+
+/* Set of rasters on the same grid, such as adjacent SRTM tiles, treated as one
+ * continuous raster. */
+class Mosaic
+{
+    private:
+        std::vector <std::unique_ptr <Raster> > m_rasters;
+        mutable size_t m_last = 0; // index of last raster found
+
+        long find (const double x, const double y) const;
+
+    public:
+        Mosaic (const std::vector <std::string> &files);
+
+        size_t size () const { return m_rasters.size (); }
+        const Raster &raster (const size_t i) const { return *m_rasters [i]; }
+
+        // Value of the pixel containing (x, y) in any raster, or NaN
+        double nearest (const double x, const double y) const;
+        // Bilinear interpolation between the centres of the four nearest
+        // pixels, which may lie in different rasters. Pixels without data are
+        // ignored, and NaN is returned only if none of the four have data.
+        double bilinear (const double x, const double y) const;
+};
+
+} // end namespace geotiff
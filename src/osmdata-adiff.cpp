@@ -0,0 +1,340 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       osmdata-adiff.cpp
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osmdata.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Extract changes from augmented diff (adiff) responses of
+ *                  the overpass API, in which each object is contained within
+ *                  an <action type="create|modify|delete"> element, either
+ *                  directly, or within <old> and <new> elements.
+ *
+ *  Limitations:    Geometries of relations are multilinestrings of all member
+ *                  ways, and are only constructed when member ways include
+ *                  coordinates (from "out geom" queries).
+ *
+ *  Dependencies:       none (rapidXML header included in osmdata)
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#include "osmdata.h"
+
+#include <cstring>
+
+namespace {
+
+const char *meta_attrs [osm_adiff::n_meta] = {
+    "version", "timestamp", "changeset", "uid", "user"
+};
+
+bool is_osm_object (XmlNodePtr pt)
+{
+    return !strcmp (pt->name (), "node") || !strcmp (pt->name (), "way") ||
+        !strcmp (pt->name (), "relation");
+}
+
+// Coordinates of all <nd> elements which have them, as given by "out geom"
+void read_nd_coords (XmlNodePtr pt, std::vector <double> &x,
+        std::vector <double> &y)
+{
+    for (XmlNodePtr it = pt->first_node ("nd"); it != nullptr;
+            it = it->next_sibling ("nd"))
+    {
+        XmlAttrPtr lat = it->first_attribute ("lat"),
+                   lon = it->first_attribute ("lon");
+        if (lat != nullptr && lon != nullptr)
+        {
+            x.push_back (std::stod (lon->value ()));
+            y.push_back (std::stod (lat->value ()));
+        }
+    }
+}
+
+} // end anonymous namespace
+
+void osm_adiff::read_object (XmlNodePtr pt, const std::string &action,
+        const bool is_new, std::vector <Change> &changes)
+{
+    Change ch;
+    ch.type = pt->name ();
+    ch.action = action;
+    ch.is_new = is_new;
+
+    for (XmlAttrPtr a = pt->first_attribute (); a != nullptr;
+            a = a->next_attribute ())
+    {
+        if (!strcmp (a->name (), "id"))
+            ch.id = a->value ();
+        else if (!strcmp (a->name (), "lat"))
+            ch.lat = std::stod (a->value ());
+        else if (!strcmp (a->name (), "lon"))
+            ch.lon = std::stod (a->value ());
+        else if (!strcmp (a->name (), "visible"))
+            ch.visible = strcmp (a->value (), "false") ? TRUE : FALSE;
+        else
+        {
+            for (size_t i = 0; i < n_meta; i++)
+                if (!strcmp (a->name (), meta_attrs [i]))
+                {
+                    ch.meta [i] = a->value ();
+                    ch.has_meta [i] = true;
+                }
+        }
+    }
+    ch.has_latlon = !ISNA (ch.lat) && !ISNA (ch.lon);
+
+    for (XmlNodePtr it = pt->first_node (); it != nullptr;
+            it = it->next_sibling ())
+    {
+        if (!strcmp (it->name (), "tag"))
+        {
+            XmlAttrPtr k = it->first_attribute ("k"),
+                       v = it->first_attribute ("v");
+            if (k != nullptr && v != nullptr)
+                ch.tags.push_back (std::make_pair (std::string (k->value ()),
+                            std::string (v->value ())));
+        } else if (!strcmp (it->name (), "center"))
+        {
+            XmlAttrPtr lat = it->first_attribute ("lat"),
+                       lon = it->first_attribute ("lon");
+            if (lat != nullptr && lon != nullptr)
+            {
+                ch.lat = std::stod (lat->value ());
+                ch.lon = std::stod (lon->value ());
+                ch.has_center = true;
+            }
+        } else if (!strcmp (it->name (), "member"))
+        {
+            XmlAttrPtr type = it->first_attribute ("type");
+            if (type == nullptr || strcmp (type->value (), "way"))
+                continue;
+            std::vector <double> x, y;
+            read_nd_coords (it, x, y);
+            if (x.size () > 1)
+            {
+                ch.x.push_back (x);
+                ch.y.push_back (y);
+            }
+        }
+    }
+
+    if (ch.type == "way")
+    {
+        std::vector <double> x, y;
+        read_nd_coords (pt, x, y);
+        ch.x.push_back (x);
+        ch.y.push_back (y);
+    }
+
+    changes.push_back (ch);
+}
+
+void osm_adiff::read_action (XmlNodePtr pt, std::vector <Change> &changes)
+{
+    XmlAttrPtr type = pt->first_attribute ("type");
+    const std::string action = type == nullptr ? "" : type->value ();
+
+    for (XmlNodePtr it = pt->first_node (); it != nullptr;
+            it = it->next_sibling ())
+    {
+        const bool is_old = !strcmp (it->name (), "old");
+        if (is_old || !strcmp (it->name (), "new"))
+        {
+            for (XmlNodePtr obj = it->first_node (); obj != nullptr;
+                    obj = obj->next_sibling ())
+                if (is_osm_object (obj))
+                    read_object (obj, action, !is_old, changes);
+        } else if (is_osm_object (it))
+            read_object (it, action, true, changes); // "create" actions
+    }
+}
+
+// WKB geometry of one change: a POINT for nodes (empty without coordinates); a
+// POLYGON for closed ways and LINESTRING otherwise (empty without
+// coordinates); and a MULTILINESTRING of member ways for relations.
+Rcpp::RawVector osm_adiff::wkb_geometry (const Change &ch,
+        std::string &geom_type)
+{
+    if (ch.type == "node")
+    {
+        geom_type = "points";
+        if (ch.has_latlon)
+            return osm_convert::wkb_point (ch.lon, ch.lat);
+        return osm_convert::wkb_point (R_NaN, R_NaN);
+    }
+
+    const size_t nhead = 1 + sizeof (uint32_t), ncount = sizeof (uint32_t),
+          nxy = 2 * sizeof (double);
+
+    if (ch.type == "way")
+    {
+        const std::vector <double> &x = ch.x [0], &y = ch.y [0];
+        const size_t n = x.size ();
+        const bool polygon = n > 3 && x [0] == x [n - 1] && y [0] == y [n - 1];
+        geom_type = polygon ? "polygons" : "lines";
+
+        Rcpp::RawVector res (nhead + ncount * (polygon ? 2 : 1) + n * nxy);
+        unsigned char *p = res.begin ();
+        if (polygon)
+        {
+            p = osm_convert::wkb_put_header (p, osm_convert::wkb_type::polygon);
+            p = osm_convert::wkb_put_uint32 (p, 1);
+        } else
+            p = osm_convert::wkb_put_header (p,
+                    osm_convert::wkb_type::linestring);
+        p = osm_convert::wkb_put_uint32 (p, static_cast <uint32_t> (n));
+        for (size_t i = 0; i < n; i++)
+            p = osm_convert::wkb_put_xy (p, x [i], y [i]);
+        return res;
+    }
+
+    geom_type = "multilines";
+    size_t nbytes = nhead + ncount;
+    for (const auto &x: ch.x)
+        nbytes += nhead + ncount + x.size () * nxy;
+
+    Rcpp::RawVector res (nbytes);
+    unsigned char *p = res.begin ();
+    p = osm_convert::wkb_put_header (p, osm_convert::wkb_type::multilinestring);
+    p = osm_convert::wkb_put_uint32 (p, static_cast <uint32_t> (ch.x.size ()));
+    for (size_t j = 0; j < ch.x.size (); j++)
+    {
+        p = osm_convert::wkb_put_header (p, osm_convert::wkb_type::linestring);
+        p = osm_convert::wkb_put_uint32 (p,
+                static_cast <uint32_t> (ch.x [j].size ()));
+        for (size_t i = 0; i < ch.x [j].size (); i++)
+            p = osm_convert::wkb_put_xy (p, ch.x [j] [i], ch.y [j] [i]);
+    }
+    return res;
+}
+
+//' rcpp_osmdata_adiff
+//'
+//' Extract all changes from an augmented diff (adiff) response of the
+//' overpass API as a table, with one row for each version of each object.
+//'
+//' @param st Text contents of an overpass API query
+//' @param geometry If `true`, include WKB geometries of each object.
+//' @return Rcpp::List of columns of "osm_type", "osm_id", "action", "is_new"
+//' (`TRUE` for objects within <new> elements or "create" actions), "visible",
+//' "center_lat", "center_lon", the five metadata columns, and a character
+//' matrix of "tags". Scalar values of "has_center" and "has_meta" flag whether
+//' centers and metadata are present, and if `geometry` is `true`, "geometry"
+//' holds a list of WKB raw vectors, and "geom_type" the kind of `osmdata_sf`
+//' object for each.
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_osmdata_adiff (const std::string& st, const bool geometry)
+{
+    std::vector <osm_adiff::Change> changes;
+    {
+        XmlDocPtr p = parseXML (st);
+        XmlNodePtr osm = p->first_node ("osm");
+        if (osm != nullptr)
+        {
+            for (XmlNodePtr it = osm->first_node ("action"); it != nullptr;
+                    it = it->next_sibling ("action"))
+                osm_adiff::read_action (it, changes);
+        }
+    }
+
+    const size_t n = changes.size ();
+
+    std::set <std::string> keyset;
+    for (const auto &ch: changes)
+        for (const auto &kv: ch.tags)
+            keyset.insert (kv.first);
+    std::unordered_map <std::string, int> key_index;
+    int k = 0;
+    for (auto key: keyset)
+        key_index.emplace (key, k++);
+
+    Rcpp::CharacterVector osm_type (n), osm_id (n), action (n);
+    Rcpp::LogicalVector is_new (n), visible (n);
+    Rcpp::NumericVector center_lat (n), center_lon (n);
+    std::vector <Rcpp::CharacterVector> meta (osm_adiff::n_meta);
+    for (size_t j = 0; j < osm_adiff::n_meta; j++)
+        meta [j] = Rcpp::CharacterVector (n);
+    Rcpp::CharacterMatrix tags (Rcpp::Dimension (n, keyset.size ()));
+    std::fill (tags.begin (), tags.end (), NA_STRING);
+    Rcpp::List geoms (geometry ? n : 0);
+    Rcpp::CharacterVector geom_type (geometry ? n : 0);
+
+    bool any_center = false, all_latlon = n > 0, all_meta = n > 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        const osm_adiff::Change &ch = changes [i];
+        osm_type [i] = ch.type;
+        osm_id [i] = ch.id;
+        action [i] = ch.action;
+        is_new [i] = ch.is_new;
+        visible [i] = ch.visible;
+        center_lat [i] = ch.lat;
+        center_lon [i] = ch.lon;
+        any_center = any_center || ch.has_center;
+        all_latlon = all_latlon && ch.has_latlon;
+
+        for (size_t j = 0; j < osm_adiff::n_meta; j++)
+        {
+            all_meta = all_meta && ch.has_meta [j];
+            if (ch.has_meta [j])
+                meta [j] [i] = ch.meta [j];
+            else
+                meta [j] [i] = NA_STRING;
+        }
+
+        for (const auto &kv: ch.tags)
+            tags (static_cast <int> (i), key_index.at (kv.first)) = kv.second;
+
+        if (geometry)
+        {
+            std::string type;
+            geoms [i] = osm_adiff::wkb_geometry (ch, type);
+            geom_type [i] = type;
+        }
+    }
+    tags.attr ("dimnames") = Rcpp::List::create (R_NilValue, keyset);
+
+    Rcpp::List res = Rcpp::List::create (
+            Rcpp::Named ("osm_type") = osm_type,
+            Rcpp::Named ("osm_id") = osm_id,
+            Rcpp::Named ("action") = action,
+            Rcpp::Named ("is_new") = is_new,
+            Rcpp::Named ("visible") = visible,
+            Rcpp::Named ("center_lat") = center_lat,
+            Rcpp::Named ("center_lon") = center_lon,
+            Rcpp::Named ("osm_version") = meta [0],
+            Rcpp::Named ("osm_timestamp") = meta [1],
+            Rcpp::Named ("osm_changeset") = meta [2],
+            Rcpp::Named ("osm_uid") = meta [3],
+            Rcpp::Named ("osm_user") = meta [4],
+            Rcpp::Named ("tags") = tags,
+            Rcpp::Named ("has_center") = any_center || all_latlon,
+            Rcpp::Named ("has_meta") = all_meta);
+
+    if (geometry)
+    {
+        geoms.attr ("class") = "WKB";
+        res.push_back (geoms, "geometry");
+        res.push_back (geom_type, "geom_type");
+    }
+
+    return res;
+}
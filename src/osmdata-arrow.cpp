@@ -0,0 +1,462 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       osmdata-arrow.cpp
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osm-router.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Extract OSM data from an object of class XmlData and write
+ *                  it to Arrow IPC files with GeoArrow-encoded geometries.
+ *
+ *  Limitations:
+ *
+ *  Dependencies:       none (rapidXML header included in osmdata)
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#include "osmdata.h"
+
+#include <Rcpp.h>
+
+#include <limits>
+#include <numeric>
+
+// Geometries are encoded following https://geoarrow.org/format, as nested
+// lists of coordinates which are either interleaved ("xy" fixed-size lists) or
+// separated ("x" and "y" struct fields). Nothing here creates R objects except
+// for the final vector of file names.
+
+namespace {
+
+const std::string geoarrow_crs = "{\"crs\":\"OGC:CRS84\",\"crs_type\":\"authority_code\"}";
+
+arrow_ipc::Column coord_column (const std::string &name,
+        const std::vector <double> &x, const std::vector <double> &y,
+        const bool interleaved)
+{
+    arrow_ipc::Column col;
+    col.name = name;
+    col.length = static_cast <int64_t> (x.size ());
+    if (interleaved)
+    {
+        std::vector <double> xy (2 * x.size ());
+        for (size_t i = 0; i < x.size (); i++)
+        {
+            xy [2 * i] = x [i];
+            xy [2 * i + 1] = y [i];
+        }
+        col.type = arrow_ipc::arrow_type::fixed_size_list;
+        col.list_size = 2;
+        col.children.push_back (arrow_ipc::float64_column ("xy", xy));
+    } else
+    {
+        col.type = arrow_ipc::arrow_type::struct_;
+        col.children.push_back (arrow_ipc::float64_column ("x", x));
+        col.children.push_back (arrow_ipc::float64_column ("y", y));
+    }
+    return col;
+}
+
+/* Wrap coordinates in nested lists. 'offsets' and 'names' run from the
+ * outermost level (features) to the innermost (vertices), with 'names' holding
+ * the GeoArrow names of the child fields of each level. */
+arrow_ipc::Column geometry_column (const std::vector <double> &x,
+        const std::vector <double> &y, const osmt_arr2 &offsets,
+        const std::vector <std::string> &names, const std::string &extension,
+        const bool interleaved)
+{
+    if (x.size () > static_cast <size_t> (std::numeric_limits <int32_t>::max ()))
+        throw std::runtime_error ("too many coordinates for arrow offsets");
+
+    arrow_ipc::Column col = coord_column (names.size () > 0 ? names.back () :
+            "geometry", x, y, interleaved);
+    for (size_t i = offsets.size (); i > 0; i--)
+    {
+        const std::vector <int32_t> off (offsets [i - 1].begin (),
+                offsets [i - 1].end ());
+        col = arrow_ipc::list_column (i > 1 ? names [i - 2] : "geometry", off,
+                std::move (col));
+    }
+    col.metadata.push_back (std::make_pair ("ARROW:extension:name",
+                "geoarrow." + extension));
+    col.metadata.push_back (std::make_pair ("ARROW:extension:metadata",
+                geoarrow_crs));
+    return col;
+}
+
+// One nullable string column for each key, in alphabetical order. Keys which
+// clash with other columns of the layer are renamed, as for other outputs.
+class TagColumns
+{
+    private:
+        std::map <std::string, arrow_ipc::StringColumn> m_cols;
+
+    public:
+        void set (const int64_t row,
+                const std::map <std::string, std::string> &key_val)
+        {
+            for (auto kv = key_val.begin (); kv != key_val.end (); ++kv)
+                m_cols [kv->first].set (row, kv->second);
+        }
+
+        void finish (const int64_t nrow, std::vector <arrow_ipc::Column> &cols,
+                std::set <std::string> &renamed)
+        {
+            osm_convert::ReservedNames reserved {"geometry"};
+            for (const auto &c: cols)
+                reserved.insert (c.name);
+            std::vector <std::string> keys;
+            keys.reserve (m_cols.size ());
+            for (auto c = m_cols.begin (); c != m_cols.end (); ++c)
+                keys.push_back (c->first);
+            const std::vector <std::string> names =
+                osm_convert::rename_reserved (keys, reserved, renamed);
+
+            size_t i = 0;
+            for (auto c = m_cols.begin (); c != m_cols.end (); ++c)
+                cols.push_back (c->second.finish (names [i++], nrow));
+            m_cols.clear ();
+        }
+};
+
+void append_ring (const std::vector <double> &lons,
+        const std::vector <double> &lats, std::vector <double> &x,
+        std::vector <double> &y, std::vector <osmid_t> &offsets)
+{
+    x.insert (x.end (), lons.begin (), lons.end ());
+    y.insert (y.end (), lats.begin (), lats.end ());
+    offsets.push_back (static_cast <osmid_t> (x.size ()));
+}
+
+} // end anonymous namespace
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **          1. PRIMARY FUNCTIONS TO TRACE WAYS AND RELATIONS          **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+
+//' get_osm_relations
+//'
+//' Trace OSM relations into Arrow columns of `multipolygon` and
+//' `multilinestring` geometries.
+//'
+//' @param rels Pointer to the vector of Relation objects
+//' @param ways Pointer to the vector of way objects
+//' @param nodes Pointer to the vector of node objects
+//' @param merge_lines If `true`, contiguous member ways of multilinestring
+//'     relations are merged into single linestrings.
+//' @param interleaved If `true`, coordinates are interleaved, otherwise
+//'     separated.
+//' @param multipolygons Vector to hold the columns of multipolygon relations.
+//' @param multilines Vector to hold the columns of multilinestring relations.
+//' @param renamed New names of any keys renamed to avoid clashes with other
+//'     columns are inserted here.
+//'
+//' @noRd
+void osm_arrow::get_osm_relations (const Relations &rels, const Ways &ways,
+        const Nodes &nodes, const bool merge_lines, const bool interleaved,
+        std::vector <arrow_ipc::Column> &multipolygons,
+        std::vector <arrow_ipc::Column> &multilines,
+        std::set <std::string> &renamed)
+{
+    double_arr2 lat_vec, lon_vec;
+    string_arr2 rowname_vec;
+    std::vector <std::string> ids_mp, ids_ls_merged;
+    std::vector <osmid_t> ids_ls;
+
+    std::vector <double> x_mp, y_mp, x_ls, y_ls;
+    osmt_arr2 offsets_mp (3, std::vector <osmid_t> (1, 0)),
+        offsets_ls (2, std::vector <osmid_t> (1, 0));
+    std::vector <int64_t> rel_id_mp, rel_id_ls;
+    arrow_ipc::StringColumn roles_ls;
+    TagColumns tags_mp, tags_ls;
+
+    for (auto itr = rels.begin (); itr != rels.end (); ++itr)
+    {
+        Rcpp::checkUserInterrupt ();
+        if (itr->ispoly)
+        {
+            lon_vec.clear ();
+            lat_vec.clear ();
+            rowname_vec.clear ();
+            ids_mp.clear ();
+            trace_multipolygon (itr, ways, nodes, lon_vec, lat_vec,
+                    rowname_vec, ids_mp);
+            if (rowname_vec.size () == 0) // as for 'mp_okay' in osmdata-sf
+                continue;
+
+            // All rings are written as a single polygon, as for sf output
+            for (size_t i = 0; i < lon_vec.size (); i++)
+                append_ring (lon_vec [i], lat_vec [i], x_mp, y_mp,
+                        offsets_mp [2]);
+            offsets_mp [1].push_back (static_cast <osmid_t>
+                    (offsets_mp [2].size () - 1));
+            offsets_mp [0].push_back (static_cast <osmid_t>
+                    (offsets_mp [1].size () - 1));
+
+            tags_mp.set (static_cast <int64_t> (rel_id_mp.size ()),
+                    itr->key_val);
+            rel_id_mp.push_back (itr->id);
+        } else
+        {
+            std::set <std::string> roles_set;
+            for (auto itw = itr->ways.begin (); itw != itr->ways.end (); ++itw)
+                roles_set.insert (itw->second);
+            for (std::string role: roles_set)
+            {
+                lon_vec.clear ();
+                lat_vec.clear ();
+                rowname_vec.clear ();
+                ids_ls.clear ();
+                ids_ls_merged.clear ();
+                if (merge_lines)
+                    trace_multilinestring_merged (itr, role, ways, nodes,
+                            lon_vec, lat_vec, rowname_vec, ids_ls_merged);
+                else
+                    trace_multilinestring (itr, role, ways, nodes,
+                            lon_vec, lat_vec, rowname_vec, ids_ls);
+
+                for (size_t i = 0; i < lon_vec.size (); i++)
+                    append_ring (lon_vec [i], lat_vec [i], x_ls, y_ls,
+                            offsets_ls [1]);
+                offsets_ls [0].push_back (static_cast <osmid_t>
+                        (offsets_ls [1].size () - 1));
+
+                const int64_t row = static_cast <int64_t> (rel_id_ls.size ());
+                roles_ls.set (row, role);
+                tags_ls.set (row, itr->key_val);
+                rel_id_ls.push_back (itr->id);
+            }
+        }
+    }
+
+    multipolygons.clear ();
+    if (rel_id_mp.size () > 0)
+    {
+        const int64_t n = static_cast <int64_t> (rel_id_mp.size ());
+        multipolygons.push_back (arrow_ipc::int64_column ("osm_id", rel_id_mp));
+        tags_mp.finish (n, multipolygons, renamed);
+        multipolygons.push_back (geometry_column (x_mp, y_mp, offsets_mp,
+                    {"polygons", "rings", "vertices"}, "multipolygon",
+                    interleaved));
+    }
+
+    multilines.clear ();
+    if (rel_id_ls.size () > 0)
+    {
+        const int64_t n = static_cast <int64_t> (rel_id_ls.size ());
+        multilines.push_back (arrow_ipc::int64_column ("osm_id", rel_id_ls));
+        multilines.push_back (roles_ls.finish ("role", n));
+        multilines.back ().nullable = false;
+        tags_ls.finish (n, multilines, renamed);
+        multilines.push_back (geometry_column (x_ls, y_ls, offsets_ls,
+                    {"linestrings", "vertices"}, "multilinestring",
+                    interleaved));
+    }
+}
+
+//' get_osm_ways
+//'
+//' Store OSM ways as Arrow columns of `linestring` or `polygon` geometries.
+//'
+//' @param way_index Vector of iterators to the ways to trace
+//' @param nodes Pointer to all nodes in data set
+//' @param geom_type Character string specifying "POLYGON" or "LINESTRING"
+//' @param interleaved If `true`, coordinates are interleaved, otherwise
+//'     separated.
+//' @param renamed New names of any keys renamed to avoid clashes with other
+//'     columns are inserted here.
+//'
+//' @noRd
+std::vector <arrow_ipc::Column> osm_arrow::get_osm_ways (
+        const WayIndex &way_index, const Nodes &nodes,
+        const std::string &geom_type, const bool interleaved,
+        std::set <std::string> &renamed)
+{
+    if (!(geom_type == "POLYGON" || geom_type == "LINESTRING"))
+        throw std::runtime_error ("geom_type must be POLYGON or LINESTRING");
+    const bool polygon = geom_type == "POLYGON";
+
+    std::vector <arrow_ipc::Column> cols;
+    if (way_index.size () == 0)
+        return cols;
+
+    std::vector <double> x, y;
+    std::vector <int64_t> way_id;
+    way_id.reserve (way_index.size ());
+    // Polygons have one ring each, so feature offsets are simply 0, 1, 2, ...
+    osmt_arr2 offsets;
+    if (polygon)
+    {
+        offsets.push_back (std::vector <osmid_t> (way_index.size () + 1));
+        std::iota (offsets [0].begin (), offsets [0].end (), 0);
+    }
+    offsets.push_back (std::vector <osmid_t> (1, 0));
+    TagColumns tags;
+
+    for (auto wj: way_index)
+    {
+        Rcpp::checkUserInterrupt ();
+        for (auto ni: wj->second.nodes)
+        {
+            auto nd = nodes.find (ni);
+            if (nd == nodes.end ())
+                continue;
+            x.push_back (nd->second.lon);
+            y.push_back (nd->second.lat);
+        }
+        offsets.back ().push_back (static_cast <osmid_t> (x.size ()));
+
+        tags.set (static_cast <int64_t> (way_id.size ()), wj->second.key_val);
+        way_id.push_back (wj->first);
+    }
+
+    cols.push_back (arrow_ipc::int64_column ("osm_id", way_id));
+    tags.finish (static_cast <int64_t> (way_id.size ()), cols, renamed);
+    if (polygon)
+        cols.push_back (geometry_column (x, y, offsets, {"rings", "vertices"},
+                    "polygon", interleaved));
+    else
+        cols.push_back (geometry_column (x, y, offsets, {"vertices"},
+                    "linestring", interleaved));
+
+    return cols;
+}
+
+//' get_osm_nodes
+//'
+//' Store OSM nodes as Arrow columns of `point` geometries.
+//'
+//' @param nodes Pointer to all nodes in data set
+//' @param interleaved If `true`, coordinates are interleaved, otherwise
+//'     separated.
+//' @param renamed New names of any keys renamed to avoid clashes with other
+//'     columns are inserted here.
+//'
+//' @noRd
+std::vector <arrow_ipc::Column> osm_arrow::get_osm_nodes (const Nodes &nodes,
+        const bool interleaved, std::set <std::string> &renamed)
+{
+    std::vector <arrow_ipc::Column> cols;
+    if (nodes.size () == 0)
+        return cols;
+
+    std::vector <double> x, y;
+    std::vector <int64_t> node_id;
+    x.reserve (nodes.size ());
+    y.reserve (nodes.size ());
+    node_id.reserve (nodes.size ());
+    TagColumns tags;
+
+    int64_t count = 0;
+    for (auto ni = nodes.begin (); ni != nodes.end (); ++ni)
+    {
+        if (count % 1000 == 0)
+            Rcpp::checkUserInterrupt ();
+
+        x.push_back (ni->second.lon);
+        y.push_back (ni->second.lat);
+        node_id.push_back (ni->first);
+        tags.set (count++, ni->second.key_val);
+    }
+
+    cols.push_back (arrow_ipc::int64_column ("osm_id", node_id));
+    tags.finish (count, cols, renamed);
+    cols.push_back (geometry_column (x, y, {}, {}, "point", interleaved));
+
+    return cols;
+}
+
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **          THE FINAL RCPP FUNCTION CALLED BY osmdata_arrow           **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+//' rcpp_osmdata_arrow
+//'
+//' Write OSM data to Arrow IPC files, one for each kind of geometry.
+//'
+//' @param st Text contents of an overpass API query
+//' @param path Directory in which to write files
+//' @param merge_lines If `true`, contiguous member ways of multilinestring
+//'     relations are merged into single linestrings.
+//' @param resolve_relations If `true`, member ways of nested relations are
+//'     added to their parent relations.
+//' @param area_tags If `true`, closed ways are classified as polygons or
+//'     lines according to their tags, otherwise all closed ways are polygons.
+//' @param interleaved If `true`, coordinates are interleaved, otherwise
+//'     separated.
+//' @param stream If `true`, write the IPC streaming format, otherwise the IPC
+//'     file format.
+//' @return Named vector of the files written; empty geometry types are not
+//'     written. Names of any keys renamed to avoid clashes with other columns
+//'     are in the "renamed_keys" attribute.
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::CharacterVector rcpp_osmdata_arrow (const std::string& st,
+        const std::string& path, const bool merge_lines,
+        const bool resolve_relations, const bool area_tags,
+        const bool interleaved, const bool stream)
+{
+    XmlData xml (st, area_tags);
+    if (resolve_relations)
+        xml.resolveRelations ();
+
+    const std::string ext = stream ? ".arrows" : ".arrow";
+    std::vector <std::string> layers, files;
+
+    auto write_layer = [&] (const std::string &layer,
+            const std::vector <arrow_ipc::Column> &cols) {
+        if (cols.size () == 0)
+            return;
+        const std::string f = path + "/" + layer + ext;
+        arrow_ipc::write_table (f, cols, stream);
+        layers.push_back (layer);
+        files.push_back (f);
+    };
+
+    std::set <std::string> renamed;
+    write_layer ("points", osm_arrow::get_osm_nodes (xml.nodes (),
+                interleaved, renamed));
+    write_layer ("lines", osm_arrow::get_osm_ways (xml.line_ways (),
+                xml.nodes (), "LINESTRING", interleaved, renamed));
+    write_layer ("polygons", osm_arrow::get_osm_ways (xml.poly_ways (),
+                xml.nodes (), "POLYGON", interleaved, renamed));
+
+    std::vector <arrow_ipc::Column> multipolygons, multilines;
+    osm_arrow::get_osm_relations (xml.relations (), xml.ways (), xml.nodes (),
+            merge_lines, interleaved, multipolygons, multilines, renamed);
+    write_layer ("multilines", multilines);
+    write_layer ("multipolygons", multipolygons);
+
+    Rcpp::CharacterVector ret = Rcpp::wrap (files);
+    ret.attr ("names") = layers;
+    if (renamed.size () > 0)
+        ret.attr ("renamed_keys") = osm_convert::utf8_vector (
+                std::vector <std::string> (renamed.begin (), renamed.end ()));
+    return ret;
+}
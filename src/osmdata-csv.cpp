@@ -0,0 +1,240 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       osmdata-csv.cpp
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osmdata.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Read the tab-separated responses of "out:csv" overpass
+ *                  queries directly into a data.frame, optionally with
+ *                  integer and numeric columns.
+ *
+ *  Limitations:    Only the default tab separator of the overpass API is
+ *                  recognised. Values containing separators or quotes are
+ *                  quoted with '"', and quotes within values doubled.
+ *
+ *  Dependencies:       none
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#include "osmdata.h"
+
+#include <cstdlib>
+
+namespace {
+
+// Special "::" fields which are always character, even when they look like
+// numbers. The overpass API writes "::id" as "@id" in the header.
+const std::unordered_set <std::string> character_fields = {
+    "@id", "@type", "@otype", "@timestamp", "@user"
+};
+
+} // end anonymous namespace
+
+// Parse the whole body in a single pass. Unquoted contents of all fields are
+// appended to one buffer, and each field is recorded by its offset and length
+// within that buffer.
+void osm_csv::parse (const std::string &st, const bool header, Table &tab)
+{
+    const char sep = '\t', quote = '"';
+    const size_t n = st.size ();
+    tab.buf.reserve (n);
+
+    std::vector <Field> fields;
+    size_t nrecords = 0, i = 0;
+    while (i < n)
+    {
+        fields.clear ();
+        bool end_of_record = false;
+        while (!end_of_record)
+        {
+            const size_t offset = tab.buf.size ();
+            while (i < n && st [i] != sep && st [i] != '\n' && st [i] != '\r')
+            {
+                if (st [i] == quote)
+                {
+                    i++;
+                    while (i < n)
+                    {
+                        if (st [i] == quote)
+                        {
+                            if (i + 1 < n && st [i + 1] == quote)
+                                i++;
+                            else
+                                break;
+                        }
+                        tab.buf.push_back (st [i++]);
+                    }
+                    i++; // closing quote
+                } else
+                {
+                    size_t j = i;
+                    while (j < n && st [j] != sep && st [j] != quote &&
+                            st [j] != '\n' && st [j] != '\r')
+                        j++;
+                    tab.buf.append (st, i, j - i);
+                    i = j;
+                }
+            }
+            fields.push_back (Field {offset, tab.buf.size () - offset});
+
+            if (i < n && st [i] == sep)
+                i++;
+            else
+            {
+                if (i < n && st [i] == '\r')
+                    i++;
+                if (i < n && st [i] == '\n')
+                    i++;
+                end_of_record = true;
+            }
+        }
+
+        // Blank lines are only values when there is a single column
+        if (fields.size () == 1 && fields [0].len == 0 &&
+                tab.cols.size () != 1)
+            continue;
+
+        if (header && nrecords == 0)
+        {
+            for (const auto &f: fields)
+                tab.names.push_back (tab.buf.substr (f.offset, f.len));
+            tab.buf.clear ();
+            tab.cols.resize (tab.names.size ());
+        } else
+        {
+            if (fields.size () > tab.cols.size ())
+            {
+                if (header)
+                    throw std::runtime_error ("line " +
+                            std::to_string (nrecords + 1) +
+                            " has more fields than column names");
+                tab.cols.resize (fields.size ());
+                for (auto &c: tab.cols)
+                    c.resize (tab.nrow, Field {0, 0});
+            }
+            for (size_t j = 0; j < tab.cols.size (); j++)
+                tab.cols [j].push_back (j < fields.size () ?
+                        fields [j] : Field {0, 0});
+            tab.nrow++;
+        }
+        nrecords++;
+    }
+
+    for (size_t j = tab.names.size (); j < tab.cols.size (); j++)
+        tab.names.push_back ("V" + std::to_string (j + 1));
+}
+
+osm_csv::ColType osm_csv::infer_type (const Table &tab, const size_t j)
+{
+    if (character_fields.count (tab.names [j]) > 0)
+        return ColType::character;
+
+    ColType type = ColType::integer;
+    bool all_na = true;
+    int ival;
+    for (const auto &f: tab.cols [j])
+    {
+        if (f.len == 0)
+            continue;
+        all_na = false;
+        const char *p = tab.buf.data () + f.offset;
+        if (type == ColType::integer && !parse_integer (p, f.len, ival))
+            type = ColType::real;
+        if (type == ColType::real && !is_real (p, f.len))
+            return ColType::character;
+    }
+
+    return all_na ? ColType::character : type;
+}
+
+//' rcpp_osmdata_csv
+//'
+//' Read the response of an "out:csv" overpass query into a data.frame.
+//'
+//' @param st Text contents of an overpass API query
+//' @param header If `true`, the first line holds the column names, otherwise
+//' columns are named "V1", "V2", and so on.
+//' @param typed If `true`, columns in which all values are integers or numbers
+//' are returned as integer or numeric vectors. Special fields of IDs, types,
+//' timestamps and users are always character.
+//' @return A data.frame in which empty values are `NA`.
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_osmdata_csv (const std::string& st, const bool header,
+        const bool typed)
+{
+    osm_csv::Table tab;
+    osm_csv::parse (st, header, tab);
+
+    const size_t ncol = tab.cols.size (), nrow = tab.nrow;
+    Rcpp::List res (ncol);
+    for (size_t j = 0; j < ncol; j++)
+    {
+        const std::vector <osm_csv::Field> &col = tab.cols [j];
+        const osm_csv::ColType type = typed ?
+            osm_csv::infer_type (tab, j) : osm_csv::ColType::character;
+
+        if (type == osm_csv::ColType::integer)
+        {
+            Rcpp::IntegerVector x (nrow, NA_INTEGER);
+            for (size_t i = 0; i < nrow; i++)
+                if (col [i].len > 0)
+                    parse_integer (tab.buf.data () + col [i].offset,
+                            col [i].len, x [i]);
+            res [j] = x;
+        } else if (type == osm_csv::ColType::real)
+        {
+            // Values are not null-terminated within the buffer
+            Rcpp::NumericVector x (nrow, NA_REAL);
+            std::string value;
+            for (size_t i = 0; i < nrow; i++)
+                if (col [i].len > 0)
+                {
+                    value.assign (tab.buf, col [i].offset, col [i].len);
+                    x [i] = std::strtod (value.c_str (), nullptr);
+                }
+            res [j] = x;
+        } else
+        {
+            Rcpp::CharacterVector x (nrow);
+            for (size_t i = 0; i < nrow; i++)
+            {
+                if (col [i].len == 0)
+                    SET_STRING_ELT (x, i, NA_STRING);
+                else
+                    SET_STRING_ELT (x, i, Rf_mkCharLenCE (tab.buf.data () +
+                                col [i].offset, static_cast <int> (col [i].len),
+                                CE_UTF8));
+            }
+            res [j] = x;
+        }
+    }
+
+    Rcpp::CharacterVector nms (ncol);
+    for (size_t j = 0; j < ncol; j++)
+        SET_STRING_ELT (nms, j, Rf_mkCharLenCE (tab.names [j].c_str (),
+                    static_cast <int> (tab.names [j].size ()), CE_UTF8));
+    res.attr ("names") = nms;
+    res.attr ("class") = "data.frame";
+    res.attr ("row.names") = Rcpp::IntegerVector::create (NA_INTEGER,
+            -static_cast <int> (nrow));
+
+    return res;
+}
@@ -20,9 +20,9 @@
  *  E-Mail:     mark.padgham@email.com
  *
  *  Description:    Modified version of 'osmdata-sf' to extract OSM data from an
- *                  object of class XmlData and return it in Rcpp::List format,
- *                  but in this case ignoring the actual geometric data. The
- *                  returned object contains key-value data only, for return
+ *                  object of class XmlData, but in this case ignoring the
+ *                  actual geometric data. The returned object is the final
+ *                  data.frame of key-value data of all objects, for return
  *                  from the R function 'osmdata_data_frame'.
  *
  *  Limitations:
@@ -35,6 +35,7 @@
 #include "osmdata.h"
 
 #include <Rcpp.h>
+#include <cstdio>
 #include <list>
 #include <string>
 
@@ -43,232 +44,179 @@
 // static_cast <size_t> (std::distance (...)). This operation copies each
 // instance and can slow the loops down by several orders of magnitude!
 
+namespace {
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+long days_from_civil (long y, const long m, const long d)
+{
+    y -= m <= 2;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const long yoe = y - era * 400;
+    const long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Seconds since the epoch of an ISO 8601 timestamp of "%Y-%m-%dT%H:%M:%SZ",
+// or NA for any other format.
+double parse_timestamp (const std::string &ts)
+{
+    int y, mo, d, h, mi, s;
+    char z;
+    if (ts.size () != 20 || sscanf (ts.c_str (), "%4d-%2d-%2dT%2d:%2d:%2d%c",
+                &y, &mo, &d, &h, &mi, &s, &z) != 7 || z != 'Z')
+        return NA_REAL;
+    return 86400.0 * days_from_civil (y, mo, d) + 3600.0 * h + 60.0 * mi + s;
+}
+
+template <typename T>
+void fill_row (osm_df::Columns &cols, const unsigned int row,
+        const char *type, const osmid_t id, const T &obj, const double lat,
+        const double lon)
+{
+    cols.osm_type [row] = type;
+    cols.osm_id [row] = std::to_string (id);
+    cols.center_lat [row] = lat;
+    cols.center_lon [row] = lon;
+
+    const std::string *meta [osm_df::n_meta] = {&obj._version, &obj._timestamp,
+        &obj._changeset, &obj._uid, &obj._user};
+    for (size_t j = 0; j < osm_df::n_meta; j++)
+    {
+        if (meta [j]->empty ())
+            continue;
+        cols.has_meta [j] = true;
+        if (j == 1)
+            cols.timestamp [row] = parse_timestamp (*meta [j]);
+        else
+            osm_convert::set_utf8 (cols.meta [j], row, *meta [j]);
+    }
+
+    for (const auto &kv: obj.key_val)
+    {
+        Rcpp::CharacterVector &col = cols.tags [cols.key_index.at (kv.first)];
+        if (osm_convert::keep_value (cols.unique_vals, kv.first, col [row]))
+            osm_convert::set_utf8 (col, row, kv.second);
+    }
+}
+
+} // end anonymous namespace
+
 /************************************************************************
  ************************************************************************
  **                                                                    **
- **          1. PRIMARY FUNCTIONS TO TRACE WAYS AND RELATIONS          **
+ **          1. PRIMARY FUNCTIONS TO FILL ROWS OF EACH OSM TYPE        **
  **                                                                    **
  ************************************************************************
  ************************************************************************/
 
+osm_df::Columns::Columns (const size_t nrow,
+        const std::set <std::string> &keys, const UniqueVals &unique_vals) :
+    osm_type (nrow), osm_id (nrow), center_lat (nrow, NA_REAL),
+    center_lon (nrow, NA_REAL), timestamp (nrow, NA_REAL), meta (n_meta),
+    unique_vals (unique_vals)
+{
+    for (size_t j = 0; j < n_meta; j++)
+        if (j != 1)
+            meta [j] = Rcpp::CharacterVector (nrow, NA_STRING);
+
+    // Keys may share columns, as resolved in XmlData::make_key_val_indices
+    std::unordered_map <std::string, unsigned int> name_index;
+    for (const auto &k: keys)
+    {
+        const std::string &name = unique_vals.k_names.at (k);
+        auto it = name_index.emplace (name,
+                static_cast <unsigned int> (tags.size ()));
+        if (it.second)
+        {
+            tags.push_back (Rcpp::CharacterVector (nrow, NA_STRING));
+            tag_names.push_back (name);
+        }
+        key_index.emplace (k, it.first->second);
+    }
+}
 
 //' get_osm_relations
 //'
-//' Return a dual Rcpp::DataFrame containing all OSM relations.
+//' Fill the rows of all OSM relations in the final columns.
 //'
 //' @param rels Pointer to the vector of Relation objects
-//' @param unique_vals Pointer to a UniqueVals object containing std::sets of
-//'     all unique IDs and keys for each kind of OSM object (nodes, ways, rels).
+//' @param cols Columns of the final data.frame
+//' @param row Index of the first row to fill; incremented for each relation.
 //'
-//' @return A list with three Rcpp::DataFrame with the tags, centers and
-//'     metadata of the relations.
+//' @return true if any relation has a center.
 //'
 //' @noRd
-Rcpp::List osm_df::get_osm_relations (const Relations &rels,
-        const UniqueVals &unique_vals)
+bool osm_df::get_osm_relations (const Relations &rels, Columns &cols,
+        unsigned int &row)
 {
-
-    const unsigned int nmp = static_cast <unsigned int> (rels.size ());
-    Rcpp::List res = Rcpp::List::create (R_NilValue, R_NilValue, R_NilValue);
-    if (nmp == 0L) {
-        return res;
-    }
-
-    size_t ncol = unique_vals.k_rel.size ();
-    std::vector <std::string> rel_ids;
-    rel_ids.reserve (nmp);
-
-    Rcpp::CharacterMatrix kv_mat (Rcpp::Dimension (nmp, ncol));
-    std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
-    Rcpp::CharacterMatrix meta (Rcpp::Dimension (nmp, 5L));
-    std::fill (meta.begin (), meta.end (), NA_STRING);
-    Rcpp::NumericMatrix center (Rcpp::Dimension (nmp, 2L));
-    std::fill (center.begin (), center.end (), NA_REAL);
-
-    unsigned int count = 0;
-
+    bool has_center = false;
     for (auto itr = rels.begin (); itr != rels.end (); ++itr)
     {
-        if (count % 1000 == 0)
+        if (row % 1000 == 0)
             Rcpp::checkUserInterrupt ();
 
-        rel_ids.push_back (std::to_string (itr->id));
-
-        meta (count, 0L) = itr->_version;
-        meta (count, 1L) = itr->_timestamp;
-        meta (count, 2L) = itr->_changeset;
-        meta (count, 3L) = itr->_uid;
-        meta (count, 4L) = itr->_user;
-
-        center (count, 0L) = itr->_lat;
-        center (count, 1L) = itr->_lon;
-
-        osm_convert::get_value_mat_rel (itr, unique_vals, kv_mat, count++);
+        fill_row (cols, row++, "relation", itr->id, *itr, itr->_lat, itr->_lon);
+        has_center = has_center || !ISNA (itr->_lat);
     }
 
-    Rcpp::DataFrame kv_df;
-
-    kv_mat.attr ("dimnames") = Rcpp::List::create (rel_ids, unique_vals.k_rel);
-    kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
-
-    meta.attr ("dimnames") = Rcpp::List::create (rel_ids, metanames);
-    center.attr ("dimnames") = Rcpp::List::create (rel_ids, centernames);
-
-    res (0) = kv_df;
-    res (1) = meta;
-    res (2) = center;
-
-    rel_ids.clear ();
-
-    return res;
+    return has_center;
 }
 
 //' get_osm_ways
 //'
-//' Store key-val pairs for OSM ways as a list/data.frame
+//' Fill the rows of all OSM ways in the final columns.
 //'
-//' @param kv_df Pointer to Rcpp::DataFrame to hold key-value pairs.
-//' @param way_ids Vector of <osmid_t> IDs of ways to trace.
 //' @param ways Pointer to all ways in data set.
-//' @param unique_vals pointer to all unique values (OSM IDs and keys) in data
-//'     set.
+//' @param cols Columns of the final data.frame
+//' @param row Index of the first row to fill; incremented for each way.
+//'
+//' @return true if any way has a center.
 //'
 //' @noRd
-Rcpp::List osm_df::get_osm_ways (
-        const std::set <osmid_t> &way_ids, const Ways &ways,
-        const UniqueVals &unique_vals)
+bool osm_df::get_osm_ways (const Ways &ways, Columns &cols, unsigned int &row)
 {
-
-    size_t nrow = way_ids.size (), ncol = unique_vals.k_way.size ();
-    Rcpp::List res = Rcpp::List::create (R_NilValue, R_NilValue, R_NilValue);
-    if (nrow == 0L)
+    bool has_center = false;
+    for (auto wj = ways.begin (); wj != ways.end (); ++wj)
     {
-        return res;
-    }
-
-    std::vector <std::string> waynames;
-    waynames.reserve (nrow);
-
-    Rcpp::CharacterMatrix kv_mat (Rcpp::Dimension (nrow, ncol));
-    std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
-    Rcpp::CharacterMatrix meta (Rcpp::Dimension (nrow, 5L));
-    std::fill (meta.begin (), meta.end (), NA_STRING);
-    Rcpp::NumericMatrix center (Rcpp::Dimension (nrow, 2L));
-    std::fill (center.begin (), center.end (), NA_REAL);
-
-    unsigned int count = 0;
-    for (auto wi = way_ids.begin (); wi != way_ids.end (); ++wi)
-    {
-        if (count % 1000 == 0)
+        if (row % 1000 == 0)
             Rcpp::checkUserInterrupt ();
 
-        waynames.push_back (std::to_string (*wi));
-
-        auto wj = ways.find (*wi);
-
-        meta (count, 0L) = wj->second._version;
-        meta (count, 1L) = wj->second._timestamp;
-        meta (count, 2L) = wj->second._changeset;
-        meta (count, 3L) = wj->second._uid;
-        meta (count, 4L) = wj->second._user;
-
-        center (count, 0L) = wj->second._lat;
-        center (count, 1L) = wj->second._lon;
-
-        osm_convert::get_value_mat_way (wj, unique_vals, kv_mat, count);
-        count++;
+        fill_row (cols, row++, "way", wj->first, wj->second, wj->second._lat,
+                wj->second._lon);
+        has_center = has_center || !ISNA (wj->second._lat);
     }
 
-    Rcpp::DataFrame kv_df = R_NilValue;
-
-    kv_mat.attr ("dimnames") = Rcpp::List::create (waynames, unique_vals.k_way);
-    if (kv_mat.nrow () > 0 && kv_mat.ncol () > 0)
-        kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
-
-    meta.attr ("dimnames") = Rcpp::List::create (waynames, metanames);
-    center.attr ("dimnames") = Rcpp::List::create (waynames, centernames);
-
-    res (0) = kv_df;
-    res (1) = meta;
-    res (2) = center;
-
-    waynames.clear ();
-
-    return res;
+    return has_center;
 }
 
 //' get_osm_nodes
 //'
-//' Store OSM nodes as `sf::POINT` objects
+//' Fill the rows of all OSM nodes in the final columns, with coordinates as
+//' centers.
 //'
-//' @param kv_df Pointer to Rcpp::DataFrame to hold key-value pairs.
 //' @param nodes Pointer to all nodes in data set.
-//' @param unique_vals pointer to all unique values (OSM IDs and keys) in data
-//'     set.
+//' @param cols Columns of the final data.frame
+//' @param row Index of the first row to fill; incremented for each node.
+//'
+//' @return true if any node has coordinates.
 //'
 //' @noRd
-Rcpp::List osm_df::get_osm_nodes (const Nodes &nodes,
-        const UniqueVals &unique_vals)
+bool osm_df::get_osm_nodes (const Nodes &nodes, Columns &cols,
+        unsigned int &row)
 {
-    size_t nrow = nodes.size (), ncol = unique_vals.k_point.size ();
-
-    Rcpp::CharacterMatrix kv_mat (Rcpp::Dimension (nrow, ncol));
-    std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
-    Rcpp::CharacterMatrix meta (Rcpp::Dimension (nrow, 5L));
-    std::fill (meta.begin (), meta.end (), NA_STRING);
-    Rcpp::NumericMatrix center (Rcpp::Dimension (nrow, 2L));
-    std::fill (center.begin (), center.end (), NA_REAL);
-
-    const size_t n = nodes.size ();
-    std::vector <std::string> ptnames;
-    ptnames.reserve (n);
-
-    unsigned int count = 0;
+    bool has_center = false;
     for (auto ni = nodes.begin (); ni != nodes.end (); ++ni)
     {
-        if (count % 1000 == 0)
+        if (row % 1000 == 0)
             Rcpp::checkUserInterrupt ();
 
-        ptnames.push_back (std::to_string (ni->first));
-
-        meta (count, 0L) = ni->second._version;
-        meta (count, 1L) = ni->second._timestamp;
-        meta (count, 2L) = ni->second._changeset;
-        meta (count, 3L) = ni->second._uid;
-        meta (count, 4L) = ni->second._user;
-
-        center(count, 0L) = ni->second.lat;
-        center(count, 1L) = ni->second.lon;
-
-        for (auto kv_iter = ni->second.key_val.begin ();
-                kv_iter != ni->second.key_val.end (); ++kv_iter)
-        {
-            const std::string &key = kv_iter->first;
-            unsigned int ndi = unique_vals.k_point_index.at (key);
-            kv_mat (count, ndi) = kv_iter->second;
-        }
-        count++;
+        fill_row (cols, row++, "node", ni->first, ni->second, ni->second.lat,
+                ni->second.lon);
+        has_center = has_center || !ISNA (ni->second.lat);
     }
 
-    Rcpp::DataFrame kv_df = R_NilValue;
-    Rcpp::List res = Rcpp::List::create (R_NilValue, R_NilValue, R_NilValue);
-
-    if (unique_vals.k_point.size () > 0)
-    {
-        kv_mat.attr ("dimnames") = Rcpp::List::create (ptnames, unique_vals.k_point);
-        kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
-
-        meta.attr ("dimnames") = Rcpp::List::create (ptnames, metanames);
-        center.attr ("dimnames") = Rcpp::List::create (ptnames, centernames);
-
-        res (0) = kv_df;
-        res (1) = meta;
-        res (2) = center;
-    }
-
-    ptnames.clear ();
-
-    return res;
+    return has_center;
 }
 
 
@@ -282,15 +230,26 @@ Rcpp::List osm_df::get_osm_nodes (const Nodes &nodes,
 
 //' rcpp_osmdata_df
 //'
-//' Return OSM data key-value pairs in series of data.frame objects, without any
+//' Return OSM data key-value pairs as a single data.frame, without any
 //' spatial/geometrtic information.
 //'
 //' @param st Text contents of an overpass API query
-//' @return Rcpp::List objects of OSM data
+//' @param factor_levels If positive, key columns with at most this number of
+//' distinct values are returned as factors.
+//' @param typed If `true`, key columns in which all values are logical,
+//' integer, or numeric are returned as such.
+//' @param units Named vector of factors by which to multiply numeric values
+//' with each unit suffix, when `typed` is `true`.
+//' @return A data.frame with columns of "osm_type", "osm_id", centers (only if
+//' all kinds of objects have centers), metadata (only those fields with data),
+//' and the union of all keys in sorted order. Nodes and ways are only included
+//' if at least one of them has tags. Names of any keys renamed to avoid
+//' clashes with other columns are in the "renamed_keys" attribute.
 //'
 //' @noRd
 // [[Rcpp::export]]
-Rcpp::List rcpp_osmdata_df (const std::string& st)
+Rcpp::List rcpp_osmdata_df (const std::string& st, const int factor_levels,
+        const bool typed, const Rcpp::NumericVector units)
 {
     XmlData xml (st);
 
@@ -299,71 +258,92 @@ Rcpp::List rcpp_osmdata_df (const std::string& st)
     const std::vector <Relation>& rels = xml.relations ();
     const UniqueVals& unique_vals = xml.unique_vals ();
 
-    Rcpp::DataFrame kv_rels, kv_df_ways, kv_df_points;
-    Rcpp::CharacterMatrix meta_rels, meta_ways, meta_nodes;
-    Rcpp::NumericMatrix center_rels, center_ways, center_nodes;
+    // Untagged nodes and ways are generally only members of other objects
+    const bool use_nodes = unique_vals.k_point.size () > 0,
+          use_ways = unique_vals.k_way.size () > 0;
+
+    std::set <std::string> keys (unique_vals.k_rel);
+    if (use_nodes)
+        keys.insert (unique_vals.k_point.begin (), unique_vals.k_point.end ());
+    if (use_ways)
+        keys.insert (unique_vals.k_way.begin (), unique_vals.k_way.end ());
+
+    const size_t nrow = (use_nodes ? nodes.size () : 0) +
+        (use_ways ? ways.size () : 0) + rels.size ();
+    osm_df::Columns cols (nrow, keys, unique_vals);
 
     /* --------------------------------------------------------------
-     * 1. Extract OSM Relations
+     * 1. Fill rows of nodes, ways, and relations, in that order
      * --------------------------------------------------------------*/
 
-    Rcpp::List data_rels = osm_df::get_osm_relations (rels, unique_vals);
-    if (data_rels (0) != R_NilValue)
-    {
-        kv_rels = Rcpp::as <Rcpp::DataFrame> (data_rels (0));
-        meta_rels = Rcpp::as <Rcpp::CharacterMatrix> (data_rels (1));
-        center_rels = Rcpp::as <Rcpp::NumericMatrix> (data_rels (2));
-    }
+    unsigned int row = 0;
+    bool has_center = true;
+    if (use_nodes && nodes.size () > 0)
+        has_center = osm_df::get_osm_nodes (nodes, cols, row) && has_center;
+    if (use_ways && ways.size () > 0)
+        has_center = osm_df::get_osm_ways (ways, cols, row) && has_center;
+    if (rels.size () > 0)
+        has_center = osm_df::get_osm_relations (rels, cols, row) && has_center;
+    has_center = has_center && nrow > 0;
 
     /* --------------------------------------------------------------
-     * 2. Extract OSM ways
+     * 2. Collate all columns
      * --------------------------------------------------------------*/
 
-    std::set <osmid_t> way_ids;
-    for (auto itw = ways.begin (); itw != ways.end (); ++itw)
-    {
-        way_ids.insert ((*itw).first);
-    }
+    const std::string meta_names [osm_df::n_meta] = {"osm_version",
+        "osm_timestamp", "osm_changeset", "osm_uid", "osm_user"};
 
-    Rcpp::List data_ways = osm_df::get_osm_ways (way_ids, ways, unique_vals);
-    if (data_ways (0) != R_NilValue)
+    std::vector <std::string> names {"osm_type", "osm_id"};
+    std::vector <SEXP> columns {cols.osm_type, cols.osm_id};
+    if (has_center)
     {
-        kv_df_ways = Rcpp::as <Rcpp::DataFrame> (data_ways (0));
-        meta_ways = Rcpp::as <Rcpp::CharacterMatrix> (data_ways (1));
-        center_ways = Rcpp::as <Rcpp::NumericMatrix> (data_ways (2));
+        names.push_back ("osm_center_lat");
+        names.push_back ("osm_center_lon");
+        columns.push_back (cols.center_lat);
+        columns.push_back (cols.center_lon);
     }
-
-    /* --------------------------------------------------------------
-     * 3. Extract OSM nodes
-     * --------------------------------------------------------------*/
-
-    Rcpp::List data_nodes = osm_df::get_osm_nodes (nodes, unique_vals);
-    if (data_nodes (0) != R_NilValue)
+    for (size_t j = 0; j < osm_df::n_meta; j++)
     {
-        kv_df_points = Rcpp::as <Rcpp::DataFrame> (data_nodes (0));
-        meta_nodes = Rcpp::as <Rcpp::CharacterMatrix> (data_nodes (1));
-        center_nodes = Rcpp::as <Rcpp::NumericMatrix> (data_nodes (2));
+        if (!cols.has_meta [j])
+            continue;
+        names.push_back (meta_names [j]);
+        if (j == 1)
+        {
+            cols.timestamp.attr ("class") =
+                Rcpp::CharacterVector::create ("POSIXct", "POSIXt");
+            cols.timestamp.attr ("tzone") = "UTC";
+            columns.push_back (cols.timestamp);
+        } else
+            columns.push_back (cols.meta [j]);
     }
+    // Keys are only renamed if they clash with columns emitted above
+    const osm_convert::ReservedNames reserved (names.begin (), names.end ());
+    std::set <std::string> renamed;
+    const std::vector <std::string> tag_names =
+        osm_convert::rename_reserved (cols.tag_names, reserved, renamed);
+    names.insert (names.end (), tag_names.begin (), tag_names.end ());
+    // Converted columns are held in a list to protect them from garbage
+    // collection
+    Rcpp::List tag_cols (cols.tags.size ());
+    for (size_t j = 0; j < cols.tags.size (); j++)
+        tag_cols [j] = cols.tags [j];
+    if (typed)
+        osm_convert::type_columns (tag_cols,
+                osm_convert::unit_rules (units));
+    osm_convert::factorise_columns (tag_cols, factor_levels);
+    for (size_t j = 0; j < cols.tags.size (); j++)
+        columns.push_back (tag_cols [j]);
+
+    Rcpp::List res (columns.size ());
+    for (size_t j = 0; j < columns.size (); j++)
+        res [j] = columns [j];
+    res.attr ("names") = osm_convert::utf8_vector (names);
+    res.attr ("class") = "data.frame";
+    res.attr ("row.names") = Rcpp::IntegerVector::create (NA_INTEGER,
+            -static_cast <int> (nrow));
+    if (renamed.size () > 0)
+        res.attr ("renamed_keys") = osm_convert::utf8_vector (
+                std::vector <std::string> (renamed.begin (), renamed.end ()));
 
-    /* --------------------------------------------------------------
-     * 4. Collate all data
-     * --------------------------------------------------------------*/
-
-    Rcpp::List ret (9);
-    ret [0] = kv_df_points;
-    ret [1] = kv_df_ways;
-    ret [2] = kv_rels;
-    ret [3] = meta_nodes;
-    ret [4] = meta_ways;
-    ret [5] = meta_rels;
-    ret [6] = center_nodes;
-    ret [7] = center_ways;
-    ret [8] = center_rels;
-
-    std::vector <std::string> retnames {"points_kv", "ways_kv", "rels_kv",
-        "points_meta", "ways_meta", "rels_meta",
-        "points_center", "ways_center", "rels_center"};
-    ret.attr ("names") = retnames;
-
-    return ret;
+    return res;
 }
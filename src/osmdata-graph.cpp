@@ -0,0 +1,184 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       osmdata-graph.cpp
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osm-router.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Construct routing graphs in compressed sparse row (CSR)
+ *                  format directly from the ways of OSM XML data.
+ *
+ *  Limitations:    Ways are treated as undirected unless 'directed = true';
+ *                  no "oneway" or other tags are interpreted.
+ *
+ *  Dependencies:       none (rapidXML header included in osmdata)
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#include "osmdata.h"
+#include "osmdata-sc.h"
+
+// Set of IDs of ways which have the specified key, and (optionally) one of the
+// specified values. An empty key selects all ways.
+std::unordered_set <osmid_t> osm_graph::select_ways (
+        const XmlDataSC <osmid_t> &xml, const std::string &key,
+        const std::vector <std::string> &values)
+{
+    std::unordered_set <osmid_t> ways;
+
+    if (key.empty ())
+    {
+        ways.insert (xml.get_object ().begin (), xml.get_object ().end ());
+        return ways;
+    }
+
+    const std::unordered_set <std::string> vals (values.begin (), values.end ());
+    const auto &way_id = xml.get_way_id ();
+    const auto &way_key = xml.get_way_key ();
+    const auto &way_val = xml.get_way_val ();
+    for (size_t i = 0; i < way_id.size (); i++)
+    {
+        if (way_key [i] == key && (vals.empty () || vals.count (way_val [i]) > 0))
+            ways.insert (way_id [i]);
+    }
+
+    return ways;
+}
+
+//' rcpp_osm_graph
+//'
+//' Build a routing graph in CSR format from the ways of OSM data.
+//'
+//' @param st Text contents of an overpass API query
+//' @param key Only include ways with this key, or all ways if empty.
+//' @param values If non-empty, only include ways for which 'key' has one of
+//' these values.
+//' @param directed If `false`, edges are added in both directions.
+//' @param way_index If `true`, include (0-based) indices into 'way_id' of the
+//' way of each edge.
+//' @param lengths If `true`, include haversine lengths of each edge.
+//' @return Rcpp::List of vertex IDs and coordinates, CSR offsets and targets as
+//' 0-based vertex indices, and optional way indices and edge lengths.
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_osm_graph (const std::string& st, const std::string& key,
+        const std::vector <std::string>& values, const bool directed,
+        const bool way_index, const bool lengths)
+{
+    const size_t npos = std::numeric_limits <size_t>::max ();
+
+    XmlDataSC <osmid_t> xml (st, lengths, true);
+    const std::unordered_set <osmid_t> ways =
+        osm_graph::select_ways (xml, key, values);
+
+    const auto &object = xml.get_object ();
+    const auto &ix0 = xml.get_ix0 (), &ix1 = xml.get_ix1 ();
+    const auto &d = xml.get_d ();
+
+    // Renumber all vertices of selected edges to contiguous indices, and ways
+    // likewise to indices into 'way_id':
+    std::vector <size_t> vert_index (xml.get_vert_id ().size (), npos);
+    std::vector <size_t> vert_rows;
+    std::unordered_map <osmid_t, int> way_index_map;
+    std::vector <osmid_t> way_id;
+
+    std::vector <size_t> from, to;
+    std::vector <int> way;
+    std::vector <double> dist;
+    for (size_t i = 0; i < object.size (); i++)
+    {
+        if (ix0 [i] == npos || ix1 [i] == npos || ways.count (object [i]) == 0)
+            continue;
+
+        for (size_t v: {ix0 [i], ix1 [i]})
+        {
+            if (vert_index [v] == npos)
+            {
+                vert_index [v] = vert_rows.size ();
+                vert_rows.push_back (v);
+            }
+        }
+
+        auto w = way_index_map.find (object [i]);
+        if (w == way_index_map.end ())
+        {
+            w = way_index_map.emplace (object [i],
+                    static_cast <int> (way_id.size ())).first;
+            way_id.push_back (object [i]);
+        }
+
+        from.push_back (vert_index [ix0 [i]]);
+        to.push_back (vert_index [ix1 [i]]);
+        way.push_back (w->second);
+        if (lengths)
+            dist.push_back (d [i]);
+        if (!directed)
+        {
+            from.push_back (vert_index [ix1 [i]]);
+            to.push_back (vert_index [ix0 [i]]);
+            way.push_back (w->second);
+            if (lengths)
+                dist.push_back (d [i]);
+        }
+    }
+
+    // Counting sort of edges by their source vertex:
+    const size_t nv = vert_rows.size (), ne = from.size ();
+    std::vector <int> offset (nv + 1, 0);
+    for (auto f: from)
+        offset [f + 1]++;
+    for (size_t i = 0; i < nv; i++)
+        offset [i + 1] += offset [i];
+
+    std::vector <int> pos (offset.begin (), offset.end () - 1);
+    Rcpp::IntegerVector target (ne), edge_way (way_index ? ne : 0);
+    Rcpp::NumericVector edge_d (lengths ? ne : 0);
+    for (size_t i = 0; i < ne; i++)
+    {
+        const int p = pos [from [i]]++;
+        target [p] = static_cast <int> (to [i]);
+        if (way_index)
+            edge_way [p] = way [i];
+        if (lengths)
+            edge_d [p] = dist [i];
+    }
+
+    Rcpp::NumericVector vert_id (nv), vx (nv), vy (nv);
+    for (size_t i = 0; i < nv; i++)
+    {
+        vert_id [i] = static_cast <double> (xml.get_vert_id () [vert_rows [i]]);
+        vx [i] = xml.get_vx () [vert_rows [i]];
+        vy [i] = xml.get_vy () [vert_rows [i]];
+    }
+    Rcpp::DataFrame vertex = Rcpp::DataFrame::create (
+            Rcpp::Named ("id") = vert_id,
+            Rcpp::Named ("x") = vx,
+            Rcpp::Named ("y") = vy);
+
+    Rcpp::List ret = Rcpp::List::create (
+            Rcpp::Named ("vertex") = vertex,
+            Rcpp::Named ("offset") = offset,
+            Rcpp::Named ("target") = target,
+            Rcpp::Named ("way") = edge_way,
+            Rcpp::Named ("d") = edge_d,
+            Rcpp::Named ("way_id") = Rcpp::NumericVector (way_id.begin (),
+                way_id.end ()));
+
+    return ret;
+}
@@ -0,0 +1,804 @@
+/***************************************************************************
+ *  Project:    osmdata
+ *  File:       osmdata-sc-methods.cpp
+ *  Language:   C++
+ *
+ *  osmdata is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  osmdata is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  osm-router.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author:     Mark Padgham
+ *  E-Mail:     mark.padgham@email.com
+ *
+ *  Description:    Methods for silicate (SC) objects returned by osmdata_sc,
+ *                  operating directly on R vectors.
+ *
+ *  Limitations:
+ *
+ *  Dependencies:       none
+ *
+ *  Compiler Options:   -std=c++11
+ ***************************************************************************/
+
+#include "osmdata.h"
+#include "osmdata-sc.h"
+#include "geotiff.h"
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                          COMBINE SC OBJECTS                        **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+// Values of one column as 64-bit integers, so rows of mixed types can be
+// hashed and compared without converting anything to strings. Strings are
+// represented by the addresses of their CHARSXPs, which are unique through R's
+// global string cache; doubles by their bit patterns (with -0 and 0 made
+// equal); and integers and logicals by their values.
+std::vector <uint64_t> sc_methods::column_keys (SEXP col)
+{
+    const R_xlen_t n = Rf_xlength (col);
+    std::vector <uint64_t> keys (static_cast <size_t> (n));
+
+    switch (TYPEOF (col))
+    {
+        case STRSXP:
+            for (R_xlen_t i = 0; i < n; i++)
+                keys [i] = reinterpret_cast <uintptr_t> (STRING_ELT (col, i));
+            break;
+        case REALSXP:
+        {
+            const double *x = REAL (col);
+            for (R_xlen_t i = 0; i < n; i++)
+            {
+                const double xi = x [i] + 0.0;
+                std::memcpy (&keys [i], &xi, sizeof (double));
+            }
+            break;
+        }
+        case INTSXP:
+        case LGLSXP:
+        {
+            const int *x = (TYPEOF (col) == INTSXP) ? INTEGER (col) : LOGICAL (col);
+            for (R_xlen_t i = 0; i < n; i++)
+                keys [i] = static_cast <uint64_t> (static_cast <int64_t> (x [i]));
+            break;
+        }
+        default:
+            throw std::runtime_error ("columns must be character, numeric, or logical");
+    }
+
+    return keys;
+}
+
+size_t sc_methods::RowHash::operator() (const size_t row) const
+{
+    uint64_t h = 0;
+    for (const auto &k: keys)
+    {
+        h ^= k [row] + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    }
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast <size_t> (h ^ (h >> 31));
+}
+
+bool sc_methods::RowEqual::operator() (const size_t a, const size_t b) const
+{
+    for (const auto &k: keys)
+        if (k [a] != k [b])
+            return false;
+    return true;
+}
+
+size_t sc_methods::EdgeHash::operator() (const EdgeKey &k) const
+{
+    uint64_t h = 0;
+    for (const auto &ki: k)
+        h ^= ki + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    return static_cast <size_t> (h);
+}
+
+// Element 'name' of a named list, or R_NilValue
+SEXP sc_methods::list_elt (SEXP x, const std::string &name)
+{
+    SEXP nms = Rf_getAttrib (x, R_NamesSymbol);
+    if (nms == R_NilValue)
+        return R_NilValue;
+    for (R_xlen_t i = 0; i < Rf_xlength (x); i++)
+        if (name == CHAR (STRING_ELT (nms, i)))
+            return VECTOR_ELT (x, i);
+    return R_NilValue;
+}
+
+R_xlen_t sc_methods::table_nrow (SEXP tab)
+{
+    if (tab == R_NilValue || Rf_xlength (tab) == 0)
+        return 0;
+    return Rf_xlength (VECTOR_ELT (tab, 0));
+}
+
+// Edges of all objects are identified by their two vertices and the object to
+// which they belong, because numeric edge IDs are only sequential indices, and
+// so are not unique between different objects. This fills 'edge_ids' and
+// 'oxe_ids' with new "edge_" columns for the "edge" and "object_link_edge"
+// tables of each object, with values which are unique for each distinct edge
+// across all objects. Character IDs are those of the first instance of each
+// edge; numeric IDs are sequential.
+void sc_methods::remap_edges (const Rcpp::List &x, Rcpp::List &edge_ids,
+        Rcpp::List &oxe_ids)
+{
+    std::unordered_map <EdgeKey, R_xlen_t, EdgeHash> edge_index;
+    std::vector <SEXP> first_chars; // first character ID of each edge
+    int id_type = NILSXP;
+
+    for (R_xlen_t i = 0; i < x.size (); i++)
+    {
+        SEXP edge = list_elt (VECTOR_ELT (x, i), "edge"),
+             oxe = list_elt (VECTOR_ELT (x, i), "object_link_edge");
+        if (edge == R_NilValue)
+            continue;
+
+        SEXP edge_ = list_elt (edge, "edge_");
+        if (id_type == NILSXP)
+            id_type = TYPEOF (edge_);
+        else if (TYPEOF (edge_) != id_type)
+            throw std::runtime_error ("All objects must have the same id_type");
+        const bool chr = TYPEOF (edge_) == STRSXP;
+        const bool int64 = Rf_inherits (edge_, "integer64");
+        const std::vector <uint64_t> vx0 = column_keys (list_elt (edge, ".vx0")),
+              vx1 = column_keys (list_elt (edge, ".vx1")),
+              ekeys = column_keys (edge_);
+
+        // First rows of each edge ID in object_link_edge:
+        std::vector <uint64_t> oxe_edge, oxe_obj;
+        std::unordered_map <uint64_t, size_t> oxe_row;
+        if (table_nrow (oxe) > 0)
+        {
+            oxe_edge = column_keys (list_elt (oxe, "edge_"));
+            oxe_obj = column_keys (list_elt (oxe, "object_"));
+            oxe_row.reserve (oxe_edge.size ());
+            for (size_t j = 0; j < oxe_edge.size (); j++)
+                oxe_row.emplace (oxe_edge [j], j);
+        }
+
+        const size_t n = vx0.size ();
+        Rcpp::RObject ids;
+        if (chr)
+            ids = Rcpp::CharacterVector (n);
+        else
+            ids = Rcpp::NumericVector (n);
+        std::unordered_map <uint64_t, size_t> edge_row;
+        edge_row.reserve (n);
+        for (size_t j = 0; j < n; j++)
+        {
+            edge_row.emplace (ekeys [j], j);
+            auto o = oxe_row.find (ekeys [j]);
+            const EdgeKey k = {vx0 [j], vx1 [j],
+                o == oxe_row.end () ? 0 : oxe_obj [o->second],
+                o == oxe_row.end () ? 0ULL : 1ULL};
+            const auto it = edge_index.emplace (k,
+                    static_cast <R_xlen_t> (edge_index.size ()));
+            if (chr)
+            {
+                if (it.second)
+                    first_chars.push_back (STRING_ELT (edge_, j));
+                SET_STRING_ELT (ids, j, first_chars [it.first->second]);
+            } else if (int64)
+            {
+                const int64_t id = it.first->second + 1;
+                std::memcpy (&REAL (ids) [j], &id, sizeof (double));
+            } else
+                REAL (ids) [j] = static_cast <double> (it.first->second + 1);
+        }
+        if (int64)
+            ids.attr ("class") = "integer64";
+        edge_ids [i] = ids;
+
+        if (oxe == R_NilValue)
+            continue;
+        const size_t no = oxe_edge.size ();
+        Rcpp::RObject oids;
+        if (chr)
+            oids = Rcpp::CharacterVector (no);
+        else
+            oids = Rcpp::NumericVector (no);
+        for (size_t j = 0; j < no; j++)
+        {
+            auto e = edge_row.find (oxe_edge [j]);
+            if (chr)
+                SET_STRING_ELT (oids, j, e == edge_row.end () ? NA_STRING :
+                        STRING_ELT (ids, e->second));
+            else if (e == edge_row.end ())
+                REAL (oids) [j] = NA_REAL;
+            else
+                REAL (oids) [j] = REAL (ids) [e->second];
+        }
+        if (int64)
+            oids.attr ("class") = "integer64";
+        oxe_ids [i] = oids;
+    }
+}
+
+// Bind the tables 'parts' of several objects by rows, retaining only the first
+// instance of each distinct combination of values in the 'keys' columns (or
+// all columns if empty). Any column named 'repl_name' is replaced by the
+// corresponding vector of 'repl'. All tables with any rows must have the same
+// columns, as for 'rbind'. The result is allocated once, with the columns and
+// attributes of the first such table.
+SEXP sc_methods::bind_unique (const std::vector <SEXP> &parts,
+        const std::vector <std::string> &keys, const std::string &repl_name,
+        const Rcpp::List &repl)
+{
+    SEXP tmpl = R_NilValue;
+    for (SEXP p: parts)
+        if (p != R_NilValue && (tmpl == R_NilValue || table_nrow (tmpl) == 0))
+            tmpl = p;
+    if (tmpl == R_NilValue || table_nrow (tmpl) == 0)
+        return tmpl;
+
+    SEXP nms = Rf_getAttrib (tmpl, R_NamesSymbol);
+    const R_xlen_t ncol = Rf_xlength (tmpl);
+
+    // Columns present in some but not all tables, so that the error does not
+    // depend on the order of objects:
+    std::set <std::string> all_nms, diff_nms;
+    std::vector <std::set <std::string> > part_nms;
+    for (SEXP p: parts)
+    {
+        if (table_nrow (p) == 0)
+            continue;
+        SEXP pn = Rf_getAttrib (p, R_NamesSymbol);
+        std::set <std::string> s;
+        for (R_xlen_t j = 0; j < Rf_xlength (pn); j++)
+            s.insert (CHAR (STRING_ELT (pn, j)));
+        all_nms.insert (s.begin (), s.end ());
+        part_nms.push_back (std::move (s));
+    }
+    for (const auto &nm: all_nms)
+        for (const auto &s: part_nms)
+            if (s.count (nm) == 0)
+                diff_nms.insert (nm);
+    if (!diff_nms.empty ())
+    {
+        std::string msg = "Columns differ between objects:";
+        for (const auto &nm: diff_nms)
+            msg += " " + nm;
+        throw std::runtime_error (msg);
+    }
+
+    // Columns of each non-empty part, in the order of the template:
+    std::vector <std::vector <SEXP> > cols;
+    std::vector <R_xlen_t> nrows;
+    for (size_t i = 0; i < parts.size (); i++)
+    {
+        const R_xlen_t nr = table_nrow (parts [i]);
+        if (nr == 0)
+            continue;
+        std::vector <SEXP> ci (static_cast <size_t> (ncol));
+        for (R_xlen_t j = 0; j < ncol; j++)
+        {
+            const std::string nm = CHAR (STRING_ELT (nms, j));
+            ci [j] = (nm == repl_name && repl.size () > 0) ?
+                VECTOR_ELT (repl, static_cast <R_xlen_t> (i)) :
+                list_elt (parts [i], nm);
+            if (ci [j] == R_NilValue ||
+                    TYPEOF (ci [j]) != TYPEOF (VECTOR_ELT (tmpl, j)))
+                throw std::runtime_error ("Column '" + nm +
+                        "' differs between objects");
+        }
+        cols.push_back (ci);
+        nrows.push_back (nr);
+    }
+
+    // Keys of all rows of all parts:
+    std::vector <std::vector <uint64_t> > rowkeys;
+    for (R_xlen_t j = 0; j < ncol; j++)
+    {
+        const std::string nm = CHAR (STRING_ELT (nms, j));
+        if (!keys.empty () &&
+                std::find (keys.begin (), keys.end (), nm) == keys.end ())
+            continue;
+        std::vector <uint64_t> kj;
+        for (const auto &ci: cols)
+        {
+            const std::vector <uint64_t> k = column_keys (ci [j]);
+            kj.insert (kj.end (), k.begin (), k.end ());
+        }
+        rowkeys.push_back (std::move (kj));
+    }
+
+    if (rowkeys.empty ())
+        throw std::runtime_error ("key columns not found");
+    const size_t n = rowkeys.front ().size ();
+    std::unordered_set <size_t, RowHash, RowEqual> rows (n, RowHash (rowkeys),
+            RowEqual (rowkeys));
+    // (part, row) of each retained row:
+    std::vector <std::pair <size_t, R_xlen_t> > keep;
+    size_t row = 0;
+    for (size_t i = 0; i < cols.size (); i++)
+        for (R_xlen_t r = 0; r < nrows [i]; r++)
+        {
+            if (row % 100000 == 0)
+                Rcpp::checkUserInterrupt ();
+            if (rows.insert (row++).second)
+                keep.emplace_back (i, r);
+        }
+
+    const R_xlen_t nout = static_cast <R_xlen_t> (keep.size ());
+    Rcpp::List res (ncol);
+    for (R_xlen_t j = 0; j < ncol; j++)
+    {
+        SEXP t = VECTOR_ELT (tmpl, j);
+        Rcpp::RObject out = Rf_allocVector (TYPEOF (t), nout);
+        for (R_xlen_t k = 0; k < nout; k++)
+        {
+            SEXP src = cols [keep [k].first] [j];
+            const R_xlen_t r = keep [k].second;
+            switch (TYPEOF (t))
+            {
+                case STRSXP:
+                    SET_STRING_ELT (out, k, STRING_ELT (src, r));
+                    break;
+                case REALSXP:
+                    REAL (out) [k] = REAL (src) [r];
+                    break;
+                case INTSXP:
+                    INTEGER (out) [k] = INTEGER (src) [r];
+                    break;
+                case LGLSXP:
+                    LOGICAL (out) [k] = LOGICAL (src) [r];
+                    break;
+                default:
+                    throw std::runtime_error ("columns must be character, numeric, or logical");
+            }
+        }
+        Rf_copyMostAttrib (cols.front () [j], out);
+        SET_VECTOR_ELT (res, j, out);
+    }
+    res.attr ("names") = nms;
+    res.attr ("class") = Rf_getAttrib (tmpl, R_ClassSymbol);
+    res.attr ("row.names") = Rcpp::IntegerVector::create (NA_INTEGER,
+            -static_cast <int> (nout));
+
+    return res;
+}
+
+//' rcpp_sc_c
+//'
+//' Combine several SC objects in a single pass.
+//'
+//' @param x List of SC objects.
+//' @param tables Names of all tables of all objects.
+//' @return List of the tables of 'x' bound by rows, without duplicated rows.
+//' Vertices are unique by "vertex_", edges by their vertices and "edge_", and
+//' all other tables by all columns. IDs of edges are first remapped so that
+//' each distinct edge has one ID across all objects.
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_sc_c (const Rcpp::List x, const Rcpp::CharacterVector tables)
+{
+    Rcpp::List edge_ids (x.size ()), oxe_ids (x.size ());
+    sc_methods::remap_edges (x, edge_ids, oxe_ids);
+
+    Rcpp::List res (tables.size ());
+    for (R_xlen_t t = 0; t < tables.size (); t++)
+    {
+        const std::string name = Rcpp::as <std::string> (tables [t]);
+        std::vector <SEXP> parts;
+        for (R_xlen_t i = 0; i < x.size (); i++)
+            parts.push_back (sc_methods::list_elt (VECTOR_ELT (x, i), name));
+
+        if (name == "vertex")
+            res [t] = sc_methods::bind_unique (parts, {"vertex_"}, "",
+                    Rcpp::List ());
+        else if (name == "edge")
+            res [t] = sc_methods::bind_unique (parts,
+                    {".vx0", ".vx1", "edge_"}, "edge_", edge_ids);
+        else if (name == "object_link_edge")
+            res [t] = sc_methods::bind_unique (parts, {}, "edge_", oxe_ids);
+        else
+            res [t] = sc_methods::bind_unique (parts, {}, "", Rcpp::List ());
+    }
+    res.attr ("names") = tables;
+
+    return res;
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                            TRIM SC DATA                            **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+// Crossing-number test of points within a single closed polygon. Points are
+// first compared with the bounding box of the polygon, and the remainder tested
+// by counting crossings of the polygon edges, in a loop without early exits.
+std::vector <bool> sc_methods::points_in_poly (const std::vector <double> &x,
+        const std::vector <double> &y, const std::vector <double> &px,
+        const std::vector <double> &py)
+{
+    const size_t np = px.size ();
+    std::vector <bool> res (x.size (), false);
+    if (np < 4)
+        return res;
+
+    const double xmin = *std::min_element (px.begin (), px.end ()),
+          xmax = *std::max_element (px.begin (), px.end ()),
+          ymin = *std::min_element (py.begin (), py.end ()),
+          ymax = *std::max_element (py.begin (), py.end ());
+
+    for (size_t i = 0; i < x.size (); i++)
+    {
+        const double xi = x [i], yi = y [i];
+        if (xi < xmin || xi > xmax || yi < ymin || yi > ymax)
+            continue;
+
+        bool in = false;
+        for (size_t j = 0; j < (np - 1); j++)
+        {
+            const bool crosses = (py [j] > yi) != (py [j + 1] > yi);
+            const double xcross = px [j] + (yi - py [j]) *
+                (px [j + 1] - px [j]) / (py [j + 1] - py [j]);
+            in ^= crosses && (xi < xcross);
+        }
+        res [i] = in;
+    }
+
+    return res;
+}
+
+// Flag whether the elements of an R index vector (1-based, possibly NA) are
+// set in 'flags'.
+std::vector <bool> sc_methods::index_flags (const Rcpp::IntegerVector &index,
+        const std::vector <bool> &flags)
+{
+    std::vector <bool> res (static_cast <size_t> (index.size ()), false);
+    for (R_xlen_t i = 0; i < index.size (); i++)
+        if (index [i] != NA_INTEGER)
+            res [i] = flags [static_cast <size_t> (index [i] - 1)];
+    return res;
+}
+
+//' rcpp_sc_trim
+//'
+//' Trim an SC object to within a polygon.
+//'
+//' @param x Longitudes of all vertices.
+//' @param y Latitudes of all vertices.
+//' @param poly Two-column matrix of a closed bounding polygon.
+//' @param index List of (1-based) integer indices linking the tables of the SC
+//' object: "edge_v0" and "edge_v1" into vertices; "oxe_edge" into edges;
+//' "oxe_object" and "object" into unique objects of object_link_edge;
+//' "member_object" into those same objects; and "member_relation" and
+//' "property_relation" into unique relations of relation_members.
+//' @param n_objects Number of unique objects.
+//' @param n_relations Number of unique relations.
+//' @param exclude If `true`, objects are only retained if all of their
+//' vertices lie within the polygon; otherwise if any do.
+//' @return List of logical vectors flagging which rows of each table to retain.
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_sc_trim (const Rcpp::NumericVector x,
+        const Rcpp::NumericVector y, const Rcpp::NumericMatrix poly,
+        const Rcpp::List index, const int n_objects, const int n_relations,
+        const bool exclude)
+{
+    const Rcpp::IntegerVector edge_v0 = index ["edge_v0"],
+        edge_v1 = index ["edge_v1"],
+        oxe_edge = index ["oxe_edge"],
+        oxe_object = index ["oxe_object"],
+        object = index ["object"],
+        member_object = index ["member_object"],
+        member_relation = index ["member_relation"],
+        property_relation = index ["property_relation"];
+
+    const std::vector <double> vx (x.begin (), x.end ()),
+          vy (y.begin (), y.end ());
+    std::vector <double> px (static_cast <size_t> (poly.nrow ())),
+        py (static_cast <size_t> (poly.nrow ()));
+    for (int i = 0; i < poly.nrow (); i++)
+    {
+        px [static_cast <size_t> (i)] = poly (i, 0);
+        py [static_cast <size_t> (i)] = poly (i, 1);
+    }
+
+    const std::vector <bool> vert_in = sc_methods::points_in_poly (vx, vy,
+            px, py);
+
+    // Edges are within if both (exclude) or either vertex is:
+    const std::vector <bool> in0 = sc_methods::index_flags (edge_v0, vert_in),
+          in1 = sc_methods::index_flags (edge_v1, vert_in);
+    std::vector <bool> edge_in (in0.size ());
+    for (size_t i = 0; i < in0.size (); i++)
+        edge_in [i] = exclude ? (in0 [i] && in1 [i]) : (in0 [i] || in1 [i]);
+
+    // Objects are within if all (exclude) or any of their edges are:
+    const std::vector <bool> oxe_in = sc_methods::index_flags (oxe_edge,
+            edge_in);
+    std::vector <bool> obj_in (static_cast <size_t> (n_objects), exclude);
+    for (size_t i = 0; i < oxe_in.size (); i++)
+    {
+        if (oxe_object [i] == NA_INTEGER)
+            continue;
+        const size_t o = static_cast <size_t> (oxe_object [i] - 1);
+        obj_in [o] = exclude ? (obj_in [o] && oxe_in [i]) : (obj_in [o] || oxe_in [i]);
+    }
+
+    // Entire objects are retained, along with all of their edges and vertices:
+    const std::vector <bool> oxe_keep = sc_methods::index_flags (oxe_object,
+            obj_in);
+    std::vector <bool> edge_keep (edge_in.size (), false);
+    for (size_t i = 0; i < oxe_keep.size (); i++)
+        if (oxe_keep [i] && oxe_edge [i] != NA_INTEGER)
+            edge_keep [static_cast <size_t> (oxe_edge [i] - 1)] = true;
+    std::vector <bool> vert_keep (vert_in.size (), false);
+    for (size_t i = 0; i < edge_keep.size (); i++)
+    {
+        if (!edge_keep [i])
+            continue;
+        if (edge_v0 [i] != NA_INTEGER)
+            vert_keep [static_cast <size_t> (edge_v0 [i] - 1)] = true;
+        if (edge_v1 [i] != NA_INTEGER)
+            vert_keep [static_cast <size_t> (edge_v1 [i] - 1)] = true;
+    }
+
+    // Relations are retained in full if any member objects are retained:
+    const std::vector <bool> memb_in = sc_methods::index_flags (member_object,
+            obj_in);
+    std::vector <bool> rel_in (static_cast <size_t> (n_relations), false);
+    for (size_t i = 0; i < memb_in.size (); i++)
+        if (memb_in [i] && member_relation [i] != NA_INTEGER)
+            rel_in [static_cast <size_t> (member_relation [i] - 1)] = true;
+
+    return Rcpp::List::create (
+            Rcpp::Named ("vertex") = vert_keep,
+            Rcpp::Named ("edge") = edge_keep,
+            Rcpp::Named ("object_link_edge") = oxe_keep,
+            Rcpp::Named ("object") = sc_methods::index_flags (object, obj_in),
+            Rcpp::Named ("relation_members") =
+                sc_methods::index_flags (member_relation, rel_in),
+            Rcpp::Named ("relation_properties") =
+                sc_methods::index_flags (property_relation, rel_in));
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                        CONTRACT SC NETWORKS                        **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+// Trace one chain of edges from edge 'e' through all contractible vertices,
+// assigning each edge to contracted edge 'new_edge', and returning the last
+// edge of the chain. Chains which form closed cycles end on reaching their
+// first vertex.
+int sc_methods::trace_chain (const int e, const int new_edge,
+        const std::vector <int> &v0, const std::vector <int> &v1,
+        const std::vector <bool> &contractible,
+        const std::vector <int> &out_edge, std::vector <int> &edge_map)
+{
+    int cur = e;
+    edge_map [static_cast <size_t> (cur)] = new_edge;
+    while (true)
+    {
+        const int v = v1 [static_cast <size_t> (cur)];
+        if (v < 0 || !contractible [static_cast <size_t> (v)] ||
+                v == v0 [static_cast <size_t> (e)])
+            break;
+        const int next = out_edge [static_cast <size_t> (v)];
+        if (edge_map [static_cast <size_t> (next)] >= 0)
+            break;
+        cur = next;
+        edge_map [static_cast <size_t> (cur)] = new_edge;
+    }
+    return cur;
+}
+
+//' rcpp_sc_contract
+//'
+//' Contract chains of edges through vertices of degree two which belong to a
+//' single object.
+//'
+//' @param v0 (1-based) indices of the start vertex of each edge; may be NA.
+//' @param v1 (1-based) indices of the end vertex of each edge; may be NA.
+//' @param object (1-based) indices of the object of each edge.
+//' @param n_vertices Number of vertices.
+//' @param d Lengths of each edge, or an empty vector.
+//' @return List of "edge_map" with the (1-based) contracted edge of each
+//' original edge; "first" and "last" with the (1-based) first and last
+//' original edges of each contracted edge; "order" with original edges in
+//' order along contracted edges; and "d" with summed lengths (if given).
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_sc_contract (const Rcpp::IntegerVector v0,
+        const Rcpp::IntegerVector v1, const Rcpp::IntegerVector object,
+        const int n_vertices, const Rcpp::NumericVector d)
+{
+    const size_t ne = static_cast <size_t> (v0.size ());
+    const size_t nv = static_cast <size_t> (n_vertices);
+
+    // 0-based indices, with NA as -1:
+    std::vector <int> e0 (ne), e1 (ne), obj (ne);
+    for (size_t i = 0; i < ne; i++)
+    {
+        e0 [i] = (v0 [i] == NA_INTEGER) ? -1 : v0 [i] - 1;
+        e1 [i] = (v1 [i] == NA_INTEGER) ? -1 : v1 [i] - 1;
+        obj [i] = (object [i] == NA_INTEGER) ? -1 : object [i] - 1;
+    }
+
+    // Vertices are contractible if they have exactly one incoming and one
+    // outgoing edge, both of the same object:
+    std::vector <int> n_in (nv, 0), n_out (nv, 0), in_edge (nv, -1),
+        out_edge (nv, -1);
+    for (size_t i = 0; i < ne; i++)
+    {
+        if (e0 [i] >= 0)
+        {
+            n_out [static_cast <size_t> (e0 [i])]++;
+            out_edge [static_cast <size_t> (e0 [i])] = static_cast <int> (i);
+        }
+        if (e1 [i] >= 0)
+        {
+            n_in [static_cast <size_t> (e1 [i])]++;
+            in_edge [static_cast <size_t> (e1 [i])] = static_cast <int> (i);
+        }
+    }
+    std::vector <bool> contractible (nv, false);
+    for (size_t v = 0; v < nv; v++)
+    {
+        if (n_in [v] == 1 && n_out [v] == 1)
+        {
+            const int o_in = obj [static_cast <size_t> (in_edge [v])],
+                  o_out = obj [static_cast <size_t> (out_edge [v])];
+            contractible [v] = (o_in >= 0 && o_in == o_out);
+        }
+    }
+
+    // Chains start at all edges from non-contractible vertices, and then any
+    // remaining edges form closed cycles, each of which starts anywhere:
+    std::vector <int> edge_map (ne, -1), first, last;
+    for (size_t i = 0; i < ne; i++)
+    {
+        if (e0 [i] >= 0 && contractible [static_cast <size_t> (e0 [i])])
+            continue;
+        const int new_edge = static_cast <int> (first.size ());
+        first.push_back (static_cast <int> (i));
+        last.push_back (sc_methods::trace_chain (static_cast <int> (i),
+                    new_edge, e0, e1, contractible, out_edge, edge_map));
+    }
+    for (size_t i = 0; i < ne; i++)
+    {
+        if (edge_map [i] >= 0)
+            continue;
+        const int new_edge = static_cast <int> (first.size ());
+        first.push_back (static_cast <int> (i));
+        last.push_back (sc_methods::trace_chain (static_cast <int> (i),
+                    new_edge, e0, e1, contractible, out_edge, edge_map));
+    }
+
+    // Original edges in order along each contracted edge, by following chains
+    // again from their first edges:
+    const size_t nc = first.size ();
+    Rcpp::IntegerVector order (ne);
+    int pos = 0;
+    for (size_t c = 0; c < nc; c++)
+    {
+        int cur = first [c];
+        order [pos++] = cur + 1;
+        while (cur != last [c])
+        {
+            cur = out_edge [static_cast <size_t> (e1 [static_cast <size_t> (cur)])];
+            order [pos++] = cur + 1;
+        }
+    }
+
+    Rcpp::NumericVector dsum (d.size () > 0 ? nc : 0, 0.0);
+    if (d.size () > 0)
+        for (size_t i = 0; i < ne; i++)
+            dsum [edge_map [i]] += d [i];
+
+    Rcpp::IntegerVector edge_map_r (ne), first_r (nc), last_r (nc);
+    for (size_t i = 0; i < ne; i++)
+        edge_map_r [i] = edge_map [i] + 1;
+    for (size_t c = 0; c < nc; c++)
+    {
+        first_r [c] = first [c] + 1;
+        last_r [c] = last [c] + 1;
+    }
+
+    return Rcpp::List::create (
+            Rcpp::Named ("edge_map") = edge_map_r,
+            Rcpp::Named ("first") = first_r,
+            Rcpp::Named ("last") = last_r,
+            Rcpp::Named ("order") = order,
+            Rcpp::Named ("d") = dsum);
+}
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                            SC ELEVATION                            **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+//' rcpp_sc_elevation
+//'
+//' Sample elevations of all vertices from a mosaic of GeoTIFF files, and
+//' calculate gradients of all edges.
+//'
+//' @param files Paths to one or more uncompressed GeoTIFF files on a common
+//' grid, such as adjacent SRTM tiles.
+//' @param x Longitudes of all vertices.
+//' @param y Latitudes of all vertices.
+//' @param v0 (1-based) indices of the start vertex of each edge; may be NA.
+//' @param v1 (1-based) indices of the end vertex of each edge; may be NA.
+//' @return List of "z" with bilinearly interpolated elevations of each vertex,
+//' and "gradient" with the change in elevation along each edge divided by its
+//' length. Vertices beyond all files are NA, as are edges with any such
+//' vertices.
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_sc_elevation (const Rcpp::CharacterVector files,
+        const Rcpp::NumericVector x, const Rcpp::NumericVector y,
+        const Rcpp::IntegerVector v0, const Rcpp::IntegerVector v1)
+{
+    const geotiff::Mosaic mosaic (Rcpp::as <std::vector <std::string> > (files));
+
+    const size_t nv = static_cast <size_t> (x.size ());
+    std::vector <double> vx (nv), vy (nv);
+    Rcpp::NumericVector z (nv);
+    for (size_t i = 0; i < nv; i++)
+    {
+        vx [i] = x [i];
+        vy [i] = y [i];
+        const double zi = mosaic.bilinear (vx [i], vy [i]);
+        z [i] = std::isnan (zi) ? NA_REAL : zi;
+    }
+
+    const size_t ne = static_cast <size_t> (v0.size ());
+    const size_t npos = std::numeric_limits <size_t>::max ();
+    std::vector <size_t> ix0 (ne, npos), ix1 (ne, npos);
+    for (size_t i = 0; i < ne; i++)
+    {
+        if (v0 [i] != NA_INTEGER)
+            ix0 [i] = static_cast <size_t> (v0 [i] - 1);
+        if (v1 [i] != NA_INTEGER)
+            ix1 [i] = static_cast <size_t> (v1 [i] - 1);
+    }
+    std::vector <double> d, bearing;
+    edge_lengths (vx, vy, ix0, ix1, d, bearing);
+
+    Rcpp::NumericVector gradient (ne, NA_REAL);
+    for (size_t i = 0; i < ne; i++)
+    {
+        if (ix0 [i] == npos || ix1 [i] == npos || !(d [i] > 0.0))
+            continue;
+        const double z0 = z [ix0 [i]], z1 = z [ix1 [i]];
+        if (!ISNA (z0) && !ISNA (z1))
+            gradient [i] = (z1 - z0) / d [i];
+    }
+
+    return Rcpp::List::create (
+            Rcpp::Named ("z") = z,
+            Rcpp::Named ("gradient") = gradient);
+}
@@ -32,129 +32,185 @@
 #include "osmdata.h"
 #include "osmdata-sc.h"
 
-// Function to generate IDs for the edges in each way
-std::string random_id (size_t len) {
-    auto randchar = []() -> char
+// Function to generate IDs for the edges in each way. IDs are a hash of the way
+// ID and the position of the edge within the way, so identical input always
+// gives identical IDs, without using R's RNG. The hash is FNV-1a over the way
+// ID, with the position mixed in through the 'splitmix64' finaliser, and then
+// encoded as 10 base-62 characters (62^10 ~ 8e17 distinct values).
+std::string edge_id (const std::string &way_id, const size_t position)
+{
+    const char charset[] =
+        "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    const uint64_t base = sizeof (charset) - 1;
+
+    uint64_t h = 14695981039346656037ULL;
+    for (auto c: way_id)
+    {
+        h ^= static_cast <unsigned char> (c);
+        h *= 1099511628211ULL;
+    }
+    h += (static_cast <uint64_t> (position) + 1) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+
+    std::string str (10, '0');
+    for (size_t i = 0; i < 10; i++)
     {
-        const char charset[] = \
-            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-        const size_t max_index = (sizeof(charset) - 1);
-        //return charset [ rand() % max_index ];
-        size_t i = static_cast <size_t> (floor (Rcpp::runif (1) [0] * max_index));
-        return charset [i];
-    };
-    std::string str (len, 0);
-    std::generate_n (str.begin(), len, randchar);
+        str [i] = charset [h % base];
+        h /= base;
+    }
     return str;
 }
 
-Rcpp::List rel_membs_as_list (XmlDataSC &xml)
+// Haversine lengths (in metres) and initial bearings (in degrees clockwise from
+// north) of all edges, from row indices of their vertices. Coordinates are
+// first gathered into contiguous arrays, so that the main loop has no lookups
+// or branches and can be vectorised by the compiler. Edges with unknown
+// vertices are NA.
+void edge_lengths (const std::vector <double> &vx,
+        const std::vector <double> &vy, const std::vector <size_t> &v0,
+        const std::vector <size_t> &v1, std::vector <double> &d,
+        std::vector <double> &bearing)
 {
-    std::unordered_map <std::string, std::vector <std::string> >
-        rel_membs = xml.get_rel_membs ();
+    const double earth_radius = 6371008.8; // mean radius in metres
+    const double deg2rad = M_PI / 180.0;
+    const size_t n = v0.size ();
+    const size_t npos = std::numeric_limits <size_t>::max ();
 
-    Rcpp::List ret (rel_membs.size ());
-    std::vector <std::string> retnames (rel_membs.size ());
+    std::vector <double> x0 (n, 0.0), y0 (n, 0.0), x1 (n, 0.0), y1 (n, 0.0);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (v0 [i] == npos || v1 [i] == npos)
+            continue;
+        x0 [i] = vx [v0 [i]] * deg2rad;
+        y0 [i] = vy [v0 [i]] * deg2rad;
+        x1 [i] = vx [v1 [i]] * deg2rad;
+        y1 [i] = vy [v1 [i]] * deg2rad;
+    }
 
-    size_t i1 = 0; // std::vector index is size_t
-    int i2 = 0; // Rcpp index is int
-    for (auto m: rel_membs)
+    d.resize (n);
+    bearing.resize (n);
+    for (size_t i = 0; i < n; i++)
     {
-        retnames [i1++] = m.first;
-        ret [i2++] = m.second;
+        const double dx = x1 [i] - x0 [i];
+        const double sy = std::sin ((y1 [i] - y0 [i]) / 2.0);
+        const double sx = std::sin (dx / 2.0);
+        const double cy0 = std::cos (y0 [i]), cy1 = std::cos (y1 [i]);
+        const double a = sy * sy + cy0 * cy1 * sx * sx;
+        d [i] = 2.0 * earth_radius * std::asin (std::sqrt (std::min (a, 1.0)));
+
+        const double b = std::atan2 (std::sin (dx) * cy1,
+                cy0 * std::sin (y1 [i]) - std::sin (y0 [i]) * cy1 * std::cos (dx));
+        bearing [i] = std::fmod (b / deg2rad + 360.0, 360.0);
     }
-    ret.attr ("names") = retnames;
 
-    return ret;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (v0 [i] == npos || v1 [i] == npos)
+        {
+            d [i] = NA_REAL;
+            bearing [i] = NA_REAL;
+        }
+    }
 }
 
-Rcpp::List way_membs_as_list (XmlDataSC &xml)
+// Conversion of ID columns to R vectors, either as character, or numeric
+// vectors of either double or bit64::integer64 values. The latter are stored
+// as the bit patterns of 64-bit integers within doubles.
+Rcpp::RObject ids_to_r (const std::vector <std::string> &ids, const bool)
 {
-    std::unordered_map <std::string, std::vector <std::string> >
-        way_membs = xml.get_way_membs ();
-
-    Rcpp::List ret (way_membs.size ());
-    std::vector <std::string> retnames (way_membs.size ());
+    return Rcpp::wrap (ids);
+}
 
-    size_t i1 = 0;
-    int i2 = 0;
-    for (auto m: way_membs)
+Rcpp::RObject ids_to_r (const std::vector <osmid_t> &ids, const bool int64)
+{
+    Rcpp::NumericVector ret (ids.size ());
+    if (int64)
+    {
+        if (ids.size () > 0)
+            std::memcpy (&ret [0], &ids [0], ids.size () * sizeof (double));
+        ret.attr ("class") = "integer64";
+    } else
     {
-        retnames [i1] = m.first;
-        ret [i2++] = m.second;
+        std::copy (ids.begin (), ids.end (), ret.begin ());
     }
-    ret.attr ("names") = retnames;
-
     return ret;
 }
 
-//' rcpp_osmdata_sc
-//'
-//' Return OSM data in silicate (SC) format
-//'
-//' @param st Text contents of an overpass API query
-//' @return Rcpp::List objects of OSM data
-//' 
-//' @noRd 
-// [[Rcpp::export]]
-Rcpp::List rcpp_osmdata_sc (const std::string& st)
+// Members of ways or relations are returned in the CSR format in which they are
+// stored, as a list of object IDs, 0-based offsets into the 'member' vector
+// (with one more offset than objects), and the member IDs themselves.
+template <typename id_t>
+Rcpp::List membs_as_list (const MembersCSR <id_t> &membs, const bool int64)
 {
-#ifdef DUMP_INPUT
-    {
-        std::ofstream dump ("./osmdata-sf.xml");
-        if (dump.is_open())
-        {
-            dump.write (st.c_str(), st.size());
-        }
-    }
-#endif
+    Rcpp::IntegerVector offset (membs.offset.begin (), membs.offset.end ());
 
-    XmlDataSC xml (st);
+    return Rcpp::List::create (
+            Rcpp::Named ("id") = ids_to_r (membs.id, int64),
+            Rcpp::Named ("offset") = offset,
+            Rcpp::Named ("member") = ids_to_r (membs.member, int64));
+}
 
+// Convert all tables of an XmlDataSC object to R. All ID columns are passed
+// through 'ids_to_r', while all other columns are identical for both types.
+template <typename id_t>
+Rcpp::List sc_as_list (const XmlDataSC <id_t> &xml, const bool int64)
+{
     Rcpp::DataFrame vertex = Rcpp::DataFrame::create (
             Rcpp::Named ("x_") = xml.get_vx (),
             Rcpp::Named ("y_") = xml.get_vy (),
-            Rcpp::Named ("vertex_") = xml.get_vert_id (),
+            Rcpp::Named ("vertex_") = ids_to_r (xml.get_vert_id (), int64),
             Rcpp::_["stringsAsFactors"] = false );
 
-    Rcpp::DataFrame edge = Rcpp::DataFrame::create (
-            Rcpp::Named (".vx0") = xml.get_vx0 (),
-            Rcpp::Named (".vx1") = xml.get_vx1 (),
-            Rcpp::Named ("edge_") = xml.get_edge (),
-            Rcpp::_["stringsAsFactors"] = false );
+    Rcpp::DataFrame edge;
+    if (xml.has_lengths ())
+        edge = Rcpp::DataFrame::create (
+                Rcpp::Named (".vx0") = ids_to_r (xml.get_vx0 (), int64),
+                Rcpp::Named (".vx1") = ids_to_r (xml.get_vx1 (), int64),
+                Rcpp::Named ("edge_") = ids_to_r (xml.get_edge (), int64),
+                Rcpp::Named ("d_") = xml.get_d (),
+                Rcpp::Named ("bearing_") = xml.get_bearing (),
+                Rcpp::_["stringsAsFactors"] = false );
+    else
+        edge = Rcpp::DataFrame::create (
+                Rcpp::Named (".vx0") = ids_to_r (xml.get_vx0 (), int64),
+                Rcpp::Named (".vx1") = ids_to_r (xml.get_vx1 (), int64),
+                Rcpp::Named ("edge_") = ids_to_r (xml.get_edge (), int64),
+                Rcpp::_["stringsAsFactors"] = false );
 
     Rcpp::DataFrame oXe = Rcpp::DataFrame::create (
-            Rcpp::Named ("edge_") = xml.get_edge (),
-            Rcpp::Named ("object_") = xml.get_object (),
+            Rcpp::Named ("edge_") = ids_to_r (xml.get_edge (), int64),
+            Rcpp::Named ("object_") = ids_to_r (xml.get_object (), int64),
             Rcpp::_["stringsAsFactors"] = false );
 
     Rcpp::DataFrame obj_node = Rcpp::DataFrame::create (
-            Rcpp::Named ("vertex_") = xml.get_node_id (),
-            Rcpp::Named ("key") = xml.get_node_key (),
-            Rcpp::Named ("value") = xml.get_node_val (),
+            Rcpp::Named ("vertex_") = ids_to_r (xml.get_node_id (), int64),
+            Rcpp::Named ("key") = osm_convert::utf8_vector (xml.get_node_key ()),
+            Rcpp::Named ("value") = osm_convert::utf8_vector (xml.get_node_val ()),
             Rcpp::_["stringsAsFactors"] = false );
 
     Rcpp::DataFrame obj_way = Rcpp::DataFrame::create (
-            Rcpp::Named ("object_") = xml.get_way_id (),
-            Rcpp::Named ("key") = xml.get_way_key (),
-            Rcpp::Named ("value") = xml.get_way_val (),
+            Rcpp::Named ("object_") = ids_to_r (xml.get_way_id (), int64),
+            Rcpp::Named ("key") = osm_convert::utf8_vector (xml.get_way_key ()),
+            Rcpp::Named ("value") = osm_convert::utf8_vector (xml.get_way_val ()),
             Rcpp::_["stringsAsFactors"] = false );
 
     Rcpp::DataFrame obj_rel_memb = Rcpp::DataFrame::create (
-            Rcpp::Named ("relation_") = xml.get_rel_memb_id (),
-            Rcpp::Named ("member") = xml.get_rel_ref (),
+            Rcpp::Named ("relation_") = ids_to_r (xml.get_rel_memb_id (), int64),
+            Rcpp::Named ("member") = ids_to_r (xml.get_rel_ref (), int64),
             Rcpp::Named ("type") = xml.get_rel_memb_type (),
-            Rcpp::Named ("role") = xml.get_rel_role (),
+            Rcpp::Named ("role") = osm_convert::utf8_vector (xml.get_rel_role ()),
             Rcpp::_["stringsAsFactors"] = false );
 
     Rcpp::DataFrame obj_rel_kv = Rcpp::DataFrame::create (
-            Rcpp::Named ("relation_") = xml.get_rel_kv_id (),
-            Rcpp::Named ("key") = xml.get_rel_key (),
-            Rcpp::Named ("value") = xml.get_rel_val (),
+            Rcpp::Named ("relation_") = ids_to_r (xml.get_rel_kv_id (), int64),
+            Rcpp::Named ("key") = osm_convert::utf8_vector (xml.get_rel_key ()),
+            Rcpp::Named ("value") = osm_convert::utf8_vector (xml.get_rel_val ()),
             Rcpp::_["stringsAsFactors"] = false );
 
-    Rcpp::List rel_membs = rel_membs_as_list (xml),
-        way_membs = way_membs_as_list (xml);
+    Rcpp::List rel_membs = membs_as_list (xml.get_rel_membs (), int64),
+        way_membs = membs_as_list (xml.get_way_membs (), int64);
 
     Rcpp::List ret (9);
     ret [0] = vertex;
@@ -164,8 +220,8 @@ Rcpp::List rcpp_osmdata_sc (const std::string& st)
     ret [4] = obj_way; // The SC object table
     ret [5] = obj_rel_memb;
     ret [6] = obj_rel_kv;
-    ret [7] = Rcpp::as <Rcpp::List> (way_membs);
-    ret [8] = Rcpp::as <Rcpp::List> (rel_membs);
+    ret [7] = way_membs;
+    ret [8] = rel_membs;
 
     std::vector <std::string> retnames {"vertex", 
                                         "edge", "object_link_edge",
@@ -177,3 +233,38 @@ Rcpp::List rcpp_osmdata_sc (const std::string& st)
     
     return ret;
 }
+
+//' rcpp_osmdata_sc
+//'
+//' Return OSM data in silicate (SC) format
+//'
+//' @param st Text contents of an overpass API query
+//' @param id_type One of "character", "numeric", or "integer64", determining
+//' the type of all ID columns.
+//' @param lengths If `true`, add columns of edge lengths and bearings.
+//' @return Rcpp::List objects of OSM data
+//' 
+//' @noRd 
+// [[Rcpp::export]]
+Rcpp::List rcpp_osmdata_sc (const std::string& st, const std::string& id_type,
+        const bool lengths)
+{
+#ifdef DUMP_INPUT
+    {
+        std::ofstream dump ("./osmdata-sf.xml");
+        if (dump.is_open())
+        {
+            dump.write (st.c_str(), st.size());
+        }
+    }
+#endif
+
+    if (id_type == "character")
+    {
+        XmlDataSC <std::string> xml (st, lengths);
+        return sc_as_list (xml, false);
+    }
+
+    XmlDataSC <osmid_t> xml (st, lengths);
+    return sc_as_list (xml, id_type == "integer64");
+}
@@ -37,7 +37,53 @@
 #include "trace-osm.h"
 #include "convert-osm-rcpp.h"
 
-std::string random_id (size_t len);
+std::string edge_id (const std::string &way_id, const size_t position);
+
+void edge_lengths (const std::vector <double> &vx,
+        const std::vector <double> &vy, const std::vector <size_t> &v0,
+        const std::vector <size_t> &v1, std::vector <double> &d,
+        std::vector <double> &bearing);
+
+// IDs are stored either as strings, or as numeric osmid_t values when the R
+// function is called with 'id_type = "numeric"'. These overloads convert the
+// XML attribute values and generate edge IDs for either type. Numeric edge IDs
+// are simply sequential indices of edges, starting at 1.
+namespace sc_id {
+
+inline void set (std::string &id, const char *value) { id = value; }
+inline void set (osmid_t &id, const char *value)
+{
+    id = std::strtoll (value, nullptr, 10);
+}
+
+inline std::string edge (const std::string &way_id, const size_t position,
+        const size_t)
+{
+    return edge_id (way_id, position);
+}
+inline osmid_t edge (const osmid_t, const size_t, const size_t nedges)
+{
+    return static_cast <osmid_t> (nedges + 1);
+}
+
+} // end namespace sc_id
+
+// Members of ways or relations in compressed sparse row (CSR) format: The
+// members of object 'id [i]' are 'member [offset [i]]' up to (but excluding)
+// 'member [offset [i + 1]]'. Both objects and members are appended during
+// ingest, so no intermediate map is needed.
+template <typename id_t>
+struct MembersCSR
+{
+    std::vector <id_t> id, member;
+    std::vector <size_t> offset = std::vector <size_t> (1, 0);
+
+    void close (const id_t &object_id)
+    {
+        id.push_back (object_id);
+        offset.push_back (member.size ());
+    }
+};
 
 /************************************************************************
  ************************************************************************
@@ -48,6 +94,7 @@ std::string random_id (size_t len);
  ************************************************************************/
 
 
+template <typename id_t>
 class XmlDataSC
 {
     /* Two main options to efficiently store-on-reading are:
@@ -55,67 +102,79 @@ class XmlDataSC
      * copying all entries over to an appropriate Rcpp::Matrix class; or
      * 2. Setting up individual vectors for each (id, key, val), and just
      * Rcpp::wrap-ing them for return.
-     * The second is more efficient, and so is implemented here, via an initial
-     * read to determine the sizes of the vectors (in Counters), then a second
-     * read to store them.
+     * The second is more efficient, and so is implemented here. All vectors
+     * are filled in a single pass through the XML tree by appending to the end
+     * of each, so that every OSM object is only visited once, and objects could
+     * equally be fed one-by-one from a streaming parser.
+     *
+     * The template parameter is the type used to store all IDs, either
+     * std::string or osmid_t.
+     *
+     * Row indices of the vertices of each edge are optionally recorded as
+     * edges are created, which requires vertices to precede ways in the XML,
+     * as they do in all Overpass output. Any remaining edges are resolved
+     * after reading. These indices are required for edge lengths and
+     * bearings, which are calculated separately.
      */
 
     public:
 
         struct Counters {
-            // Initial function getSizes does an initial scan of the XML doc and
-            // establishes the sizes of everything with these counters
-            size_t nnodes, nnode_kv,
-                nways, nway_kv, nedges,
-                nrels, nrel_kv, nrel_memb;
-            std::string id;
+            // ID of the current object, and the previous node of the current
+            // way, from which the next edge starts
+            id_t id, ref;
         };
 
         struct Vectors {
-            // Vectors used to store the data, with sizes allocated according to
-            // the values of Counters
+            // Vectors used to store the data, filled by appending objects
             //
             // vectors for key-val pairs in object table:
-            std::vector <std::string>
-                rel_kv_id, rel_key, rel_val,
-                rel_memb_id, rel_memb_type, rel_ref, rel_role,
-                way_id, way_key, way_val,
-                node_id, node_key, node_val;
+            std::vector <id_t> rel_kv_id, rel_memb_id, rel_ref,
+                way_id, node_id;
+            std::vector <std::string> rel_key, rel_val, rel_memb_type, rel_role,
+                way_key, way_val, node_key, node_val;
 
             // vectors for edge and object_link_edge tables:
-            std::vector <std::string> vx0, vx1, edge, object;
+            std::vector <id_t> vx0, vx1, edge, object;
+            std::vector <double> d, bearing;
+            // row indices of edge vertices in the vertex table:
+            std::vector <size_t> ix0, ix1;
             // vectors for vertex table
             std::vector <double> vx, vy;
-            std::vector <std::string> vert_id;
+            std::vector <id_t> vert_id;
         };
 
-        struct Maps {
-            std::unordered_map <std::string, std::vector <std::string> >
-                rel_membs, way_membs;
+        struct Members {
+            MembersCSR <id_t> rel_membs, way_membs;
         };
 
     private:
 
         Counters counters;
         Vectors vectors;
-        Maps maps;
+        Members members;
 
-        // Number of nodes in each way, and ways in each rel
-        std::unordered_map <std::string, size_t> waySizes, relSizes;
+        bool m_lengths, m_index;
+        std::unordered_map <id_t, size_t> m_vert_index;
+
+        static const size_t npos = std::numeric_limits <size_t>::max ();
 
     public:
 
-        XmlDataSC (const std::string& str)
+        XmlDataSC (const std::string& str, const bool lengths = false,
+                const bool vertex_index = false)
+            : m_lengths (lengths), m_index (lengths || vertex_index)
         {
             // APS empty m_nodes/m_ways/m_relations constructed here, no need to explicitly clear
             XmlDocPtr p = parseXML (str);
 
-            zeroCounters ();
-            getSizes (p->first_node ());
-            vectorsResize ();
-
-            zeroCounters ();
             traverseWays (p->first_node ());
+
+            if (m_index)
+                resolveEdgeVertices ();
+            if (m_lengths)
+                edge_lengths (vectors.vx, vectors.vy, vectors.ix0, vectors.ix1,
+                        vectors.d, vectors.bearing);
         }
 
         // APS make the dtor virtual since compiler support for "final" is limited
@@ -123,234 +182,70 @@ class XmlDataSC
         {
         }
 
-        const std::vector <std::string>& get_rel_kv_id() const { return vectors.rel_kv_id;  }
+        const std::vector <id_t>& get_rel_kv_id() const { return vectors.rel_kv_id;  }
         const std::vector <std::string>& get_rel_key() const { return vectors.rel_key;  }
         const std::vector <std::string>& get_rel_val() const { return vectors.rel_val;  }
 
-        const std::vector <std::string>& get_rel_memb_id() const { return vectors.rel_memb_id;  }
+        const std::vector <id_t>& get_rel_memb_id() const { return vectors.rel_memb_id;  }
         const std::vector <std::string>& get_rel_memb_type() const { return vectors.rel_memb_type;  }
-        const std::vector <std::string>& get_rel_ref() const { return vectors.rel_ref;  }
+        const std::vector <id_t>& get_rel_ref() const { return vectors.rel_ref;  }
         const std::vector <std::string>& get_rel_role() const { return vectors.rel_role;  }
 
-        const std::vector <std::string>& get_way_id() const { return vectors.way_id;  }
+        const std::vector <id_t>& get_way_id() const { return vectors.way_id;  }
         const std::vector <std::string>& get_way_key() const { return vectors.way_key;  }
         const std::vector <std::string>& get_way_val() const { return vectors.way_val;  }
 
-        const std::vector <std::string>& get_node_id() const { return vectors.node_id;  }
+        const std::vector <id_t>& get_node_id() const { return vectors.node_id;  }
         const std::vector <std::string>& get_node_key() const { return vectors.node_key;  }
         const std::vector <std::string>& get_node_val() const { return vectors.node_val;  }
 
         // vectors for edge and object_link_edge tables:
-        const std::vector <std::string>& get_vx0 () const { return vectors.vx0;  }
-        const std::vector <std::string>& get_vx1 () const { return vectors.vx1;  }
-        const std::vector <std::string>& get_edge () const { return vectors.edge;  }
-        const std::vector <std::string>& get_object () const { return vectors.object;  }
+        const std::vector <id_t>& get_vx0 () const { return vectors.vx0;  }
+        const std::vector <id_t>& get_vx1 () const { return vectors.vx1;  }
+        const std::vector <id_t>& get_edge () const { return vectors.edge;  }
+        const std::vector <id_t>& get_object () const { return vectors.object;  }
+        const std::vector <double>& get_d () const { return vectors.d;  }
+        const std::vector <double>& get_bearing () const { return vectors.bearing;  }
+        const std::vector <size_t>& get_ix0 () const { return vectors.ix0;  }
+        const std::vector <size_t>& get_ix1 () const { return vectors.ix1;  }
+        bool has_lengths () const { return m_lengths; }
 
         // vectors for vertex table
-        const std::vector <std::string>& get_vert_id () const { return vectors.vert_id;  }
+        const std::vector <id_t>& get_vert_id () const { return vectors.vert_id;  }
         const std::vector <double>& get_vx () const { return vectors.vx;  }
         const std::vector <double>& get_vy () const { return vectors.vy;  }
 
-        const std::unordered_map <std::string, std::vector <std::string> >&
-            get_rel_membs () const { return maps.rel_membs; }
-        const std::unordered_map <std::string, std::vector <std::string> >&
-            get_way_membs () const { return maps.way_membs; }
+        const MembersCSR <id_t>& get_rel_membs () const { return members.rel_membs; }
+        const MembersCSR <id_t>& get_way_membs () const { return members.way_membs; }
 
     private:
 
-        void zeroCounters ();
-        void getSizes (XmlNodePtr pt);
-        void vectorsResize ();
-
-        void countRelation (XmlNodePtr pt);
-        void countWay (XmlNodePtr pt);
-        void countNode (XmlNodePtr pt);
-
         void traverseWays (XmlNodePtr pt); // The primary function
 
-        void traverseRelation (XmlNodePtr pt, size_t &memb_num);
+        void traverseRelation (XmlNodePtr pt);
         void traverseWay (XmlNodePtr pt, size_t& node_num);
         void traverseNode (XmlNodePtr pt);
 
-}; // end Class::XmlDataSC
-
-inline void XmlDataSC::zeroCounters ()
-{
-    counters.nnodes = 0;
-    counters.nnode_kv = 0;
-
-    counters.nways = 0;
-    counters.nway_kv = 0;
-    counters.nedges = 0;
-
-    counters.nrels = 0;
-    counters.nrel_kv = 0;
-    counters.nrel_memb = 0;
-}
-
-inline void XmlDataSC::vectorsResize ()
-{
-    vectors.rel_kv_id.resize (counters.nrel_kv);
-    vectors.rel_key.resize (counters.nrel_kv);
-    vectors.rel_val.resize (counters.nrel_kv);
-
-    vectors.rel_memb_id.resize (counters.nrel_memb);
-    vectors.rel_memb_type.resize (counters.nrel_memb);
-    vectors.rel_ref.resize (counters.nrel_memb);
-    vectors.rel_role.resize (counters.nrel_memb);
-
-    vectors.way_id.resize (counters.nway_kv);
-    vectors.way_key.resize (counters.nway_kv);
-    vectors.way_val.resize (counters.nway_kv);
-
-    vectors.node_id.resize (counters.nnode_kv);
-    vectors.node_key.resize (counters.nnode_kv);
-    vectors.node_val.resize (counters.nnode_kv);
-
-    vectors.vx0.resize (counters.nedges);
-    vectors.vx1.resize (counters.nedges);
-    vectors.edge.resize (counters.nedges);
-    vectors.object.resize (counters.nedges);
-
-    vectors.vx.resize (counters.nnodes);
-    vectors.vy.resize (counters.nnodes);
-    vectors.vert_id.resize (counters.nnodes);
-
-    for (auto m: relSizes)
-    {
-        maps.rel_membs.emplace (m.first, std::vector <std::string> (m.second));
-    }
-    for (auto m: waySizes)
-    {
-        maps.way_membs.emplace (m.first, std::vector <std::string> (m.second));
-    }
-}
-
-/************************************************************************
- ************************************************************************
- **                                                                    **
- **                         FUNCTION::GETSIZES                         **
- **                                                                    **
- ************************************************************************
- ************************************************************************/
-
-inline void XmlDataSC::getSizes (XmlNodePtr pt)
-{
-    for (XmlNodePtr it = pt->first_node (); it != nullptr;
-            it = it->next_sibling())
-    {
-        if (!strcmp (it->name(), "node"))
-        {
-            countNode (it); // increments nnode_kv
-            counters.nnodes++;
-        }
-        else if (!strcmp (it->name(), "way"))
-        {
-            size_t wayLength = counters.nedges;
-            countWay (it); // increments nway_kv, nedges
-            wayLength = counters.nedges - wayLength;
-            counters.nedges--; // counts nodes, so each way has nedges = 1 - nnodes
-            waySizes.emplace (counters.id, wayLength);
-            counters.nways++;
-        }
-        else if (!strcmp (it->name(), "relation"))
+        size_t vertIndex (const id_t &id) const
         {
-            size_t relLength = counters.nrel_memb;
-            countRelation (it); // increments nrel_kv, nrel_memb
-            relLength = counters.nrel_memb - relLength;
-            relSizes.emplace (counters.id, relLength);
-            counters.nrels++;
+            const auto v = m_vert_index.find (id);
+            if (v == m_vert_index.end ())
+                return npos;
+            return v->second;
         }
-        else
+
+        void resolveEdgeVertices ()
         {
-            getSizes (it);
+            for (size_t i = 0; i < vectors.ix0.size (); i++)
+            {
+                if (vectors.ix0 [i] == npos)
+                    vectors.ix0 [i] = vertIndex (vectors.vx0 [i]);
+                if (vectors.ix1 [i] == npos)
+                    vectors.ix1 [i] = vertIndex (vectors.vx1 [i]);
+            }
         }
-    }
-} // end function XmlDataSC::getSizes
-
-
-/************************************************************************
- ************************************************************************
- **                                                                    **
- **                       FUNCTION::COUNTRELATION                      **
- **                                                                    **
- ************************************************************************
- ************************************************************************/
-
-inline void XmlDataSC::countRelation (XmlNodePtr pt)
-{
-    // Relations can have either members or key-val pairs, counted here with
-    // separate counters
-    for (XmlAttrPtr it = pt->first_attribute (); it != nullptr;
-            it = it->next_attribute())
-    {
-        if (!strcmp (it->name(), "id"))
-            counters.id = it->value();
-        else if (!strcmp (it->name(), "type"))
-            counters.nrel_memb++;
-        else if (!strcmp (it->name(), "k"))
-            counters.nrel_kv++;
-    }
-    // allows for >1 child nodes
-    for (XmlNodePtr it = pt->first_node(); it != nullptr; it = it->next_sibling())
-    {
-        countRelation (it);
-    }
-} // end function XmlDataSC::countRelation
-
-
-/************************************************************************
- ************************************************************************
- **                                                                    **
- **                          FUNCTION::COUNTWAY                        **
- **                                                                    **
- ************************************************************************
- ************************************************************************/
-
-inline void XmlDataSC::countWay (XmlNodePtr pt)
-{
-    // Ways can have either member nodes, called "ref", or key-val pairs
-    for (XmlAttrPtr it = pt->first_attribute (); it != nullptr;
-            it = it->next_attribute())
-    {
-        if (!strcmp (it->name(), "id"))
-            counters.id = it->value();
-        else if (!strcmp (it->name(), "k"))
-            counters.nway_kv++;
-        else if (!strcmp (it->name(), "ref"))
-            counters.nedges++;
-    }
-    // allows for >1 child nodes
-    for (XmlNodePtr it = pt->first_node(); it != nullptr; it = it->next_sibling())
-    {
-        countWay (it);
-    }
-} // end function XmlDataSC::countWay
-
-
-/************************************************************************
- ************************************************************************
- **                                                                    **
- **                        FUNCTION::COUNTNODE                         **
- **                                                                    **
- ************************************************************************
- ************************************************************************/
-
-inline void XmlDataSC::countNode (XmlNodePtr pt)
-{
-    for (XmlAttrPtr it = pt->first_attribute (); it != nullptr;
-            it = it->next_attribute())
-    {
-        if (!strcmp (it->name(), "k"))
-            counters.nnode_kv++;
-    }
-    // allows for >1 child nodes
-    for (XmlNodePtr it = pt->first_node(); it != nullptr; it = it->next_sibling())
-    {
-        countNode (it);
-    }
-} // end function XmlDataSC::countNode
 
+}; // end Class::XmlDataSC
 
 /************************************************************************
  ************************************************************************
@@ -360,26 +255,31 @@ inline void XmlDataSC::countNode (XmlNodePtr pt)
  ************************************************************************
  ************************************************************************/
 
-inline void XmlDataSC::traverseWays (XmlNodePtr pt)
+template <typename id_t>
+inline void XmlDataSC <id_t>::traverseWays (XmlNodePtr pt)
 {
     for (XmlNodePtr it = pt->first_node (); it != nullptr;
             it = it->next_sibling())
     {
         if (!strcmp (it->name(), "node"))
         {
+            // Vertex values are set in traverseNode
+            vectors.vert_id.push_back (id_t ());
+            vectors.vx.push_back (0.0);
+            vectors.vy.push_back (0.0);
             traverseNode (it);
-            counters.nnodes++;
+            if (m_index)
+                m_vert_index [vectors.vert_id.back ()] = vectors.vert_id.size () - 1;
         } else if (!strcmp (it->name(), "way"))
         {
             size_t node_num = 0;
             traverseWay (it, node_num);
-            counters.nways++;
+            members.way_membs.close (counters.id);
         }
         else if (!strcmp (it->name(), "relation"))
         {
-            size_t memb_num = 0;
-            traverseRelation (it, memb_num);
-            counters.nrels++;
+            traverseRelation (it);
+            members.rel_membs.close (counters.id);
         }
         else
         {
@@ -398,7 +298,8 @@ inline void XmlDataSC::traverseWays (XmlNodePtr pt)
  ************************************************************************
  ************************************************************************/
 
-inline void XmlDataSC::traverseRelation (XmlNodePtr pt, size_t &memb_num)
+template <typename id_t>
+inline void XmlDataSC <id_t>::traverseRelation (XmlNodePtr pt)
 {
     for (XmlAttrPtr it = pt->first_attribute (); it != nullptr;
             it = it->next_attribute())
@@ -407,29 +308,32 @@ inline void XmlDataSC::traverseRelation (XmlNodePtr pt, size_t &memb_num)
         {
             // These values are always first, so all other clauses are executed
             // after this one
-            counters.id = it->value();
+            sc_id::set (counters.id, it->value());
         } else if (!strcmp (it->name(), "k"))
         {
-            vectors.rel_kv_id [counters.nrel_kv] = counters.id;
-            vectors.rel_key [counters.nrel_kv] = it->value();
+            vectors.rel_kv_id.push_back (counters.id);
+            vectors.rel_key.push_back (it->value());
+            vectors.rel_val.push_back ("");
         } else if (!strcmp (it->name(), "v"))
-            vectors.rel_val [counters.nrel_kv++] = it->value();
+            vectors.rel_val.back () = it->value();
         else if (!strcmp (it->name(), "type"))
         {
-            vectors.rel_memb_type [counters.nrel_memb] = it->value();
-            vectors.rel_memb_id [counters.nrel_memb] = counters.id;
+            // "type" is the first attribute of each member
+            vectors.rel_memb_type.push_back (it->value());
+            vectors.rel_memb_id.push_back (counters.id);
+            vectors.rel_ref.push_back (id_t ());
+            vectors.rel_role.push_back ("");
         } else if (!strcmp (it->name(), "ref"))
         {
-            vectors.rel_ref [counters.nrel_memb] = it->value();
-            // TODO: Is there a safer alternative to next line?
-            maps.rel_membs.at (counters.id) [memb_num++] = it->value();
+            sc_id::set (vectors.rel_ref.back (), it->value());
+            members.rel_membs.member.push_back (vectors.rel_ref.back ());
         } else if (!strcmp (it->name(), "role"))
-            vectors.rel_role [counters.nrel_memb++] = it->value();
+            vectors.rel_role.back () = it->value();
     }
     // allows for >1 child nodes
     for (XmlNodePtr it = pt->first_node(); it != nullptr; it = it->next_sibling())
     {
-        traverseRelation (it, memb_num);
+        traverseRelation (it);
     }
 } // end function XmlDataSC::traverseRelation
 
@@ -442,7 +346,8 @@ inline void XmlDataSC::traverseRelation (XmlNodePtr pt, size_t &memb_num)
  ************************************************************************
  ************************************************************************/
 
-inline void XmlDataSC::traverseWay (XmlNodePtr pt, size_t& node_num)
+template <typename id_t>
+inline void XmlDataSC <id_t>::traverseWay (XmlNodePtr pt, size_t& node_num)
 {
     for (XmlAttrPtr it = pt->first_attribute (); it != nullptr;
             it = it->next_attribute())
@@ -451,29 +356,33 @@ inline void XmlDataSC::traverseWay (XmlNodePtr pt, size_t& node_num)
         {
             // These values are always first, so all other clauses are executed
             // after this one
-            counters.id = it->value();
+            sc_id::set (counters.id, it->value());
         } else if (!strcmp (it->name(), "k"))
         {
-            vectors.way_id [counters.nway_kv] = counters.id;
-            vectors.way_key [counters.nway_kv] = it->value();
+            vectors.way_id.push_back (counters.id);
+            vectors.way_key.push_back (it->value());
+            vectors.way_val.push_back ("");
         } else if (!strcmp (it->name(), "v"))
-            vectors.way_val [counters.nway_kv++] = it->value();
+            vectors.way_val.back () = it->value();
         else if (!strcmp (it->name(), "ref"))
         {
-            maps.way_membs.at (counters.id) [node_num] = it->value();
-            if (node_num == 0)
-                vectors.vx0 [counters.nedges] = it->value();
-            else
+            id_t ref;
+            sc_id::set (ref, it->value());
+            members.way_membs.member.push_back (ref);
+            if (node_num > 0)
             {
-                vectors.vx1 [counters.nedges] = it->value();
-                vectors.object [counters.nedges] = counters.id;
-                vectors.edge [counters.nedges] = random_id (10);
-                counters.nedges++;
-                if (counters.nedges < vectors.vx0.size ())
+                vectors.vx0.push_back (counters.ref);
+                vectors.vx1.push_back (ref);
+                vectors.object.push_back (counters.id);
+                vectors.edge.push_back (sc_id::edge (counters.id, node_num - 1,
+                            vectors.edge.size ()));
+                if (m_index)
                 {
-                    vectors.vx0 [counters.nedges] = it->value();
+                    vectors.ix0.push_back (vertIndex (counters.ref));
+                    vectors.ix1.push_back (vertIndex (ref));
                 }
             }
+            counters.ref = ref;
             node_num++;
         }
     }
@@ -494,26 +403,26 @@ inline void XmlDataSC::traverseWay (XmlNodePtr pt, size_t& node_num)
  ************************************************************************
  ************************************************************************/
 
-inline void XmlDataSC::traverseNode (XmlNodePtr pt)
+template <typename id_t>
+inline void XmlDataSC <id_t>::traverseNode (XmlNodePtr pt)
 {
     for (XmlAttrPtr it = pt->first_attribute (); it != nullptr;
             it = it->next_attribute())
     {
         if (!strcmp (it->name(), "id"))
-            vectors.vert_id [counters.nnodes] = it->value();
+            sc_id::set (vectors.vert_id.back (), it->value());
         else if (!strcmp (it->name(), "lat"))
-            vectors.vy [counters.nnodes] = std::stod(it->value());
+            vectors.vy.back () = std::stod(it->value());
         else if (!strcmp (it->name(), "lon"))
-            vectors.vx [counters.nnodes] = std::stod(it->value());
+            vectors.vx.back () = std::stod(it->value());
         else if (!strcmp (it->name(), "k"))
-            vectors.node_key [counters.nnode_kv] = it->value();
-        else if (!strcmp (it->name(), "v"))
         {
-            vectors.node_val [counters.nnode_kv] = it->value();
-            vectors.node_id [counters.nnode_kv] =
-                vectors.vert_id [counters.nnodes]; // will always be pre-set
-            counters.nnode_kv++;
+            vectors.node_key.push_back (it->value());
+            vectors.node_val.push_back ("");
+            vectors.node_id.push_back (vectors.vert_id.back ());
         }
+        else if (!strcmp (it->name(), "v"))
+            vectors.node_val.back () = it->value();
     }
     // allows for >1 child nodes
     for (XmlNodePtr it = pt->first_node(); it != nullptr; it = it->next_sibling())
@@ -531,5 +440,10 @@ inline void XmlDataSC::traverseNode (XmlNodePtr pt)
  ************************************************************************
  ************************************************************************/
 
-Rcpp::List rel_membs_as_list (XmlDataSC &xml);
-Rcpp::List way_membs_as_list (XmlDataSC &xml);
+Rcpp::RObject ids_to_r (const std::vector <std::string> &ids, const bool);
+Rcpp::RObject ids_to_r (const std::vector <osmid_t> &ids, const bool int64);
+
+template <typename id_t>
+Rcpp::List membs_as_list (const MembersCSR <id_t> &membs, const bool int64);
+template <typename id_t>
+Rcpp::List sc_as_list (const XmlDataSC <id_t> &xml, const bool int64);
@@ -58,6 +58,9 @@
 //' @param ways Pointer to the vector of way objects
 //' @param unique_vals Pointer to a UniqueVals object containing std::sets of
 //'     all unique IDs and keys for each kind of OSM object (nodes, ways, rels).
+//' @param merge_lines If `true`, contiguous member ways of multilinestring
+//'     relations are merged into single linestrings.
+//' @param wkb If `true`, geometries are returned as WKB raw vectors.
 //'
 //' @return A Rcpp::List which contains the geometry, tags and metadata of the
 //'     multipolygon and multilinestring relations.
@@ -66,7 +69,8 @@
 Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
         const std::map <osmid_t, Node> &nodes,
         const std::map <osmid_t, OneWay> &ways, const UniqueVals &unique_vals,
-        const Rcpp::NumericVector &bbox, const Rcpp::List &crs)
+        const Rcpp::NumericVector &bbox, const Rcpp::List &crs,
+        const bool merge_lines, const bool wkb)
 {
     /* Trace all multipolygon relations. These are the only OSM types where
      * sizes are not known before, so lat-lons and node names are stored in
@@ -83,8 +87,9 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
     string_arr2 rowname_vec, id_vec_mp, roles_ls;
     string_arr3 rowname_arr_mp, rowname_arr_ls;
     std::vector <osmid_t> ids_ls;
-    std::vector <std::string> ids_mp, rel_id_mp, rel_id_ls;
+    std::vector <std::string> ids_mp, rel_id_mp, rel_id_ls, ids_ls_merged;
     osmt_arr2 id_vec_ls;
+    string_arr2 id_vec_ls_merged;
     std::vector <std::string> roles;
 
     unsigned int nmp = 0, nls = 0; // number of multipolygon and multilinestringrelations
@@ -105,12 +110,15 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
     std::vector <bool> mp_okay (nmp);
     std::fill (mp_okay.begin (), mp_okay.end (), true);
 
-    size_t ncol = unique_vals.k_rel.size ();
+    const osm_convert::KvColumns cols_mp (unique_vals.k_rel_names,
+            osm_convert::sf_reserved, false),
+        cols_ls (unique_vals.k_rel_names, osm_convert::sf_reserved_ls, true);
+    size_t ncol = cols_mp.ncol ();
     rel_id_mp.reserve (nmp);
     rel_id_ls.reserve (nls);
 
     Rcpp::CharacterMatrix kv_mat_mp (Rcpp::Dimension (nmp, ncol)),
-        kv_mat_ls (Rcpp::Dimension (nls, ncol));
+        kv_mat_ls (Rcpp::Dimension (nls, cols_ls.ncol ()));
     std::fill (kv_mat_mp.begin (), kv_mat_mp.end (), NA_STRING);
     std::fill (kv_mat_ls.begin (), kv_mat_ls.end (), NA_STRING);
     Rcpp::CharacterMatrix meta_mat_mp (Rcpp::Dimension (nmp, 5L)),
@@ -145,13 +153,14 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
             ids_mp.clear ();
             ids_mp.shrink_to_fit ();
 
-            meta_mat_mp (count_mp, 0L) = itr->_version;
-            meta_mat_mp (count_mp, 1L) = itr->_timestamp;
-            meta_mat_mp (count_mp, 2L) = itr->_changeset;
-            meta_mat_mp (count_mp, 3L) = itr->_uid;
-            meta_mat_mp (count_mp, 4L) = itr->_user;
+            osm_convert::set_utf8 (meta_mat_mp, count_mp, 0, itr->_version);
+            osm_convert::set_utf8 (meta_mat_mp, count_mp, 1, itr->_timestamp);
+            osm_convert::set_utf8 (meta_mat_mp, count_mp, 2, itr->_changeset);
+            osm_convert::set_utf8 (meta_mat_mp, count_mp, 3, itr->_uid);
+            osm_convert::set_utf8 (meta_mat_mp, count_mp, 4, itr->_user);
 
-            osm_convert::get_value_mat_rel (itr, unique_vals, kv_mat_mp, count_mp++);
+            osm_convert::get_value_mat_rel (itr, unique_vals, cols_mp,
+                    kv_mat_mp, count_mp++);
         } else // store as multilinestring
         {
             // multistrings are grouped here by roles, unlike GDAL which just
@@ -165,19 +174,19 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
             roles_set.clear ();
             for (std::string role: roles)
             {
-                trace_multilinestring (itr, role, ways, nodes,
-                        lon_vec, lat_vec, rowname_vec, ids_ls);
-                std::stringstream ss;
-                ss.str ("");
-                if (role == "")
-                    ss << std::to_string (itr->id) << "-(no role)";
+                if (merge_lines)
+                    trace_multilinestring_merged (itr, role, ways, nodes,
+                            lon_vec, lat_vec, rowname_vec, ids_ls_merged);
                 else
-                    ss << std::to_string (itr->id) << "-" << role;
-                rel_id_ls.push_back (ss.str ());
+                    trace_multilinestring (itr, role, ways, nodes,
+                            lon_vec, lat_vec, rowname_vec, ids_ls);
+                const std::string role_name = role == "" ? "(no role)" : role;
+                rel_id_ls.push_back (std::to_string (itr->id) + "-" + role_name);
                 lon_arr_ls.push_back (lon_vec);
                 lat_arr_ls.push_back (lat_vec);
                 rowname_arr_ls.push_back (rowname_vec);
                 id_vec_ls.push_back (ids_ls);
+                id_vec_ls_merged.push_back (ids_ls_merged);
 
                 lon_vec.clear ();
                 lon_vec.shrink_to_fit ();
@@ -187,14 +196,19 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
                 rowname_vec.shrink_to_fit ();
                 ids_ls.clear ();
                 ids_ls.shrink_to_fit ();
-
-                meta_mat_ls (count_ls, 0L) = itr->_version;
-                meta_mat_ls (count_ls, 1L) = itr->_timestamp;
-                meta_mat_ls (count_ls, 2L) = itr->_changeset;
-                meta_mat_ls (count_ls, 3L) = itr->_uid;
-                meta_mat_ls (count_ls, 4L) = itr->_user;
-
-                osm_convert::get_value_mat_rel (itr, unique_vals, kv_mat_ls, count_ls++);
+                ids_ls_merged.clear ();
+                ids_ls_merged.shrink_to_fit ();
+
+                osm_convert::set_utf8 (meta_mat_ls, count_ls, 0, itr->_version);
+                osm_convert::set_utf8 (meta_mat_ls, count_ls, 1, itr->_timestamp);
+                osm_convert::set_utf8 (meta_mat_ls, count_ls, 2, itr->_changeset);
+                osm_convert::set_utf8 (meta_mat_ls, count_ls, 3, itr->_uid);
+                osm_convert::set_utf8 (meta_mat_ls, count_ls, 4, itr->_user);
+
+                osm_convert::set_utf8 (kv_mat_ls, count_ls, cols_ls.role (),
+                        role_name);
+                osm_convert::get_value_mat_rel (itr, unique_vals, cols_ls,
+                        kv_mat_ls, count_ls++);
             }
             roles_ls.push_back (roles);
             roles.clear ();
@@ -243,34 +257,41 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
         meta_mat_mp = meta_mp2;
     }
 
-    Rcpp::List polygonList = osm_convert::convert_poly_linestring_to_sf <std::string>
-        (lon_arr_mp, lat_arr_mp, rowname_arr_mp, id_vec_mp, rel_id_mp,
-         "MULTIPOLYGON");
-    polygonList.attr ("n_empty") = 0;
-    polygonList.attr ("class") =
-        Rcpp::CharacterVector::create ("sfc_MULTIPOLYGON", "sfc");
-    polygonList.attr ("precision") = 0.0;
-    polygonList.attr ("bbox") = bbox;
-    polygonList.attr ("crs") = crs;
-
-    Rcpp::List linestringList = osm_convert::convert_poly_linestring_to_sf <osmid_t>
-        (lon_arr_ls, lat_arr_ls, rowname_arr_ls, id_vec_ls, rel_id_ls,
-         "MULTILINESTRING");
+    Rcpp::List polygonList;
+    if (wkb)
+        polygonList = osm_convert::convert_poly_linestring_to_wkb
+            (lon_arr_mp, lat_arr_mp, rel_id_mp, "MULTIPOLYGON");
+    else
+        polygonList = osm_convert::convert_poly_linestring_to_sf <std::string>
+            (lon_arr_mp, lat_arr_mp, rowname_arr_mp, id_vec_mp, rel_id_mp,
+             "MULTIPOLYGON");
+    osm_sf::set_sfc_attributes (polygonList, "MULTIPOLYGON", bbox, crs, wkb);
+
+    // Merged linestrings are named by concatenated way IDs, as for polygons
+    Rcpp::List linestringList;
+    if (wkb)
+        linestringList = osm_convert::convert_poly_linestring_to_wkb
+            (lon_arr_ls, lat_arr_ls, rel_id_ls, "MULTILINESTRING");
+    else if (merge_lines)
+        linestringList = osm_convert::convert_poly_linestring_to_sf <std::string>
+            (lon_arr_ls, lat_arr_ls, rowname_arr_ls, id_vec_ls_merged,
+             rel_id_ls, "MULTILINESTRING");
+    else
+        linestringList = osm_convert::convert_poly_linestring_to_sf <osmid_t>
+            (lon_arr_ls, lat_arr_ls, rowname_arr_ls, id_vec_ls, rel_id_ls,
+             "MULTILINESTRING");
     // TODO: linenames just as in ways?
     // linestringList.attr ("names") = ?
-    linestringList.attr ("n_empty") = 0;
-    linestringList.attr ("class") =
-        Rcpp::CharacterVector::create ("sfc_MULTILINESTRING", "sfc");
-    linestringList.attr ("precision") = 0.0;
-    linestringList.attr ("bbox") = bbox;
-    linestringList.attr ("crs") = crs;
+    osm_sf::set_sfc_attributes (linestringList, "MULTILINESTRING", bbox, crs,
+            wkb);
 
     Rcpp::DataFrame kv_df_ls;
     Rcpp::DataFrame meta_df_ls;
     if (rel_id_ls.size () > 0) // only if there are linestrings
     {
-        kv_mat_ls.attr ("dimnames") = Rcpp::List::create (rel_id_ls, unique_vals.k_rel);
-        kv_df_ls = osm_convert::restructure_kv_mat (kv_mat_ls, true);
+        kv_mat_ls.attr ("dimnames") = Rcpp::List::create (rel_id_ls,
+                cols_ls.names ());
+        kv_df_ls = kv_mat_ls;
         meta_mat_ls.attr ("dimnames") = Rcpp::List::create (rel_id_ls, metanames);
         meta_df_ls = meta_mat_ls;
     } else
@@ -283,8 +304,9 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
     Rcpp::DataFrame meta_df_mp;
     if (rel_id_mp.size () > 0)
     {
-        kv_mat_mp.attr ("dimnames") = Rcpp::List::create (rel_id_mp, unique_vals.k_rel);
-        kv_df_mp = osm_convert::restructure_kv_mat (kv_mat_mp, false);
+        kv_mat_mp.attr ("dimnames") = Rcpp::List::create (rel_id_mp,
+                cols_mp.names ());
+        kv_df_mp = kv_mat_mp;
         meta_mat_mp.attr ("dimnames") = Rcpp::List::create (rel_id_mp, metanames);
         meta_df_mp = meta_mat_mp;
     } else
@@ -330,29 +352,31 @@ Rcpp::List osm_sf::get_osm_relations (const Relations &rels,
 //'
 //' @param wayList Pointer to Rcpp::List to hold the resultant geometries
 //' @param kv_df Pointer to Rcpp::DataFrame to hold key-value pairs
-//' @param way_ids Vector of <osmid_t> IDs of ways to trace
-//' @param ways Pointer to all ways in data set
+//' @param way_index Vector of iterators to the ways to trace
 //' @param nodes Pointer to all nodes in data set
 //' @param unique_vals pointer to all unique values (OSM IDs and keys) in data set
 //' @param geom_type Character string specifying "POLYGON" or "LINESTRING"
 //' @param bbox Pointer to the bbox needed for `sf` construction
 //' @param crs Pointer to the crs needed for `sf` construction
+//' @param wkb If `true`, geometries are returned as WKB raw vectors.
 //'
 //' @noRd
 void osm_sf::get_osm_ways (Rcpp::List &wayList, Rcpp::DataFrame &kv_df, Rcpp::DataFrame &meta_df,
-        const std::set <osmid_t> &way_ids, const Ways &ways, const Nodes &nodes,
+        const WayIndex &way_index, const Nodes &nodes,
         const UniqueVals &unique_vals, const std::string &geom_type,
-        const Rcpp::NumericVector &bbox, const Rcpp::List &crs)
+        const Rcpp::NumericVector &bbox, const Rcpp::List &crs, const bool wkb)
 {
     if (!(geom_type == "POLYGON" || geom_type == "LINESTRING"))
         throw std::runtime_error ("geom_type must be POLYGON or LINESTRING");
     // NOTE that Rcpp `.size()` returns a **signed** int
-    if (static_cast <unsigned int> (wayList.size ()) != way_ids.size ())
+    if (static_cast <unsigned int> (wayList.size ()) != way_index.size ())
         throw std::runtime_error ("ways and IDs must have same lengths");
 
-    size_t nrow = way_ids.size (), ncol = unique_vals.k_way.size ();
+    const osm_convert::KvColumns cols (unique_vals.k_way_names,
+            osm_convert::sf_reserved, false);
+    size_t nrow = way_index.size (), ncol = cols.ncol ();
     std::vector <std::string> waynames;
-    waynames.reserve (way_ids.size ());
+    waynames.reserve (way_index.size ());
 
     Rcpp::CharacterMatrix kv_mat (Rcpp::Dimension (nrow, ncol));
     std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
@@ -360,56 +384,52 @@ void osm_sf::get_osm_ways (Rcpp::List &wayList, Rcpp::DataFrame &kv_df, Rcpp::Da
     std::fill (meta.begin (), meta.end (), NA_STRING);
 
     unsigned int count = 0;
-    for (auto wi = way_ids.begin (); wi != way_ids.end (); ++wi)
+    for (auto wj: way_index)
     {
-        //unsigned int count = static_cast <unsigned int> (
-        //        std::distance (way_ids.begin (), wi));
         Rcpp::checkUserInterrupt ();
-        waynames.push_back (std::to_string (*wi));
-        Rcpp::NumericMatrix nmat;
-        osm_convert::trace_way_nmat (ways, nodes, (*wi), nmat);
-        if (geom_type == "LINESTRING")
-        {
-            nmat.attr ("class") =
-                Rcpp::CharacterVector::create ("XY", geom_type, "sfg");
-            wayList [count] = nmat;
-        } else // polygons are lists
+        waynames.push_back (std::to_string (wj->first));
+        if (wkb)
+            wayList [count] = osm_convert::wkb_way (wj, nodes,
+                    geom_type == "POLYGON");
+        else
         {
-            Rcpp::List polyList_temp = Rcpp::List (1);
-            polyList_temp (0) = nmat;
-            polyList_temp.attr ("class") =
-                Rcpp::CharacterVector::create ("XY", geom_type, "sfg");
-            wayList [count] = polyList_temp;
+            Rcpp::NumericMatrix nmat;
+            osm_convert::trace_way_nmat (wj, nodes, nmat);
+            if (geom_type == "LINESTRING")
+            {
+                nmat.attr ("class") =
+                    Rcpp::CharacterVector::create ("XY", geom_type, "sfg");
+                wayList [count] = nmat;
+            } else // polygons are lists
+            {
+                Rcpp::List polyList_temp = Rcpp::List (1);
+                polyList_temp (0) = nmat;
+                polyList_temp.attr ("class") =
+                    Rcpp::CharacterVector::create ("XY", geom_type, "sfg");
+                wayList [count] = polyList_temp;
+            }
         }
-        auto wj = ways.find (*wi);
-        osm_convert::get_value_mat_way (wj, unique_vals, kv_mat, count);
+        osm_convert::get_value_mat_way (wj, unique_vals, cols, kv_mat, count);
 
-        meta (count, 0L) = wj->second._version;
-        meta (count, 1L) = wj->second._timestamp;
-        meta (count, 2L) = wj->second._changeset;
-        meta (count, 3L) = wj->second._uid;
-        meta (count, 4L) = wj->second._user;
+        osm_convert::set_utf8 (meta, count, 0, wj->second._version);
+        osm_convert::set_utf8 (meta, count, 1, wj->second._timestamp);
+        osm_convert::set_utf8 (meta, count, 2, wj->second._changeset);
+        osm_convert::set_utf8 (meta, count, 3, wj->second._uid);
+        osm_convert::set_utf8 (meta, count, 4, wj->second._user);
 
         count++;
     }
 
     wayList.attr ("names") = waynames;
-    wayList.attr ("n_empty") = 0;
-    std::stringstream ss;
-    ss.str ("");
-    ss << "sfc_" << geom_type;
-    std::string sfc_type = ss.str ();
-    wayList.attr ("class") = Rcpp::CharacterVector::create (sfc_type, "sfc");
-    wayList.attr ("precision") = 0.0;
-    wayList.attr ("bbox") = bbox;
-    wayList.attr ("crs") = crs;
+    osm_sf::set_sfc_attributes (wayList, geom_type, bbox, crs, wkb);
 
+    // Polygons, like points, always have a table of at least "osm_id", even
+    // when empty.
     kv_df = R_NilValue;
-    if (way_ids.size () > 0)
+    if (way_index.size () > 0 || geom_type == "POLYGON")
     {
-        kv_mat.attr ("dimnames") = Rcpp::List::create (waynames, unique_vals.k_way);
-        if (kv_mat.nrow () > 0 && kv_mat.ncol () > 0)
-            kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
+        kv_mat.attr ("dimnames") = Rcpp::List::create (waynames, cols.names ());
+        kv_df = kv_mat;
 
         meta.attr ("dimnames") = Rcpp::List::create (waynames, metanames);
         meta_df = meta;
@@ -427,13 +447,16 @@ void osm_sf::get_osm_ways (Rcpp::List &wayList, Rcpp::DataFrame &kv_df, Rcpp::Da
 //' @param unique_vals pointer to all unique values (OSM IDs and keys) in data set
 //' @param bbox Pointer to the bbox needed for `sf` construction
 //' @param crs Pointer to the crs needed for `sf` construction
+//' @param wkb If `true`, geometries are returned as WKB raw vectors.
 //'
 //' @noRd
 void osm_sf::get_osm_nodes (Rcpp::List &ptList, Rcpp::DataFrame &kv_df, Rcpp::DataFrame &meta_df,
         const Nodes &nodes, const UniqueVals &unique_vals,
-        const Rcpp::NumericVector &bbox, const Rcpp::List &crs)
+        const Rcpp::NumericVector &bbox, const Rcpp::List &crs, const bool wkb)
 {
-    size_t nrow = nodes.size (), ncol = unique_vals.k_point.size ();
+    const osm_convert::KvColumns cols (unique_vals.k_point_names,
+            osm_convert::sf_reserved, false);
+    size_t nrow = nodes.size (), ncol = cols.ncol ();
 
     if (static_cast <size_t> (ptList.size ()) != nrow)
         throw std::runtime_error ("points must have same size as nodes");
@@ -456,47 +479,78 @@ void osm_sf::get_osm_nodes (Rcpp::List &ptList, Rcpp::DataFrame &kv_df, Rcpp::Da
         if (count % 1000 == 0)
             Rcpp::checkUserInterrupt ();
 
-        // These are pointers and so need to be explicitly recreated each time,
-        // otherwise they all just point to the initial value.
-        Rcpp::NumericVector ptxy = Rcpp::NumericVector::create (NA_REAL, NA_REAL);
-        ptxy.attr ("class") = Rcpp::CharacterVector::create ("XY", "POINT", "sfg");
-        ptxy (0) = ni->second.lon;
-        ptxy (1) = ni->second.lat;
-        ptList (count) = ptxy;
+        if (wkb)
+            ptList (count) = osm_convert::wkb_point (ni->second.lon,
+                    ni->second.lat);
+        else
+        {
+            // These are pointers and so need to be explicitly recreated each
+            // time, otherwise they all just point to the initial value.
+            Rcpp::NumericVector ptxy = Rcpp::NumericVector::create (NA_REAL, NA_REAL);
+            ptxy.attr ("class") = Rcpp::CharacterVector::create ("XY", "POINT", "sfg");
+            ptxy (0) = ni->second.lon;
+            ptxy (1) = ni->second.lat;
+            ptList (count) = ptxy;
+        }
         ptnames.push_back (std::to_string (ni->first));
+        osm_convert::set_utf8 (kv_mat, count, 0, ptnames.back ());
 
-        meta (count, 0L) = ni->second._version;
-        meta (count, 1L) = ni->second._timestamp;
-        meta (count, 2L) = ni->second._changeset;
-        meta (count, 3L) = ni->second._uid;
-        meta (count, 4L) = ni->second._user;
+        osm_convert::set_utf8 (meta, count, 0, ni->second._version);
+        osm_convert::set_utf8 (meta, count, 1, ni->second._timestamp);
+        osm_convert::set_utf8 (meta, count, 2, ni->second._changeset);
+        osm_convert::set_utf8 (meta, count, 3, ni->second._uid);
+        osm_convert::set_utf8 (meta, count, 4, ni->second._user);
 
         for (auto kv_iter = ni->second.key_val.begin ();
                 kv_iter != ni->second.key_val.end (); ++kv_iter)
         {
             const std::string &key = kv_iter->first;
-            unsigned int ndi = unique_vals.k_point_index.at (key);
-            kv_mat (count, ndi) = kv_iter->second;
+            size_t ndi = cols.col (unique_vals.k_point_index.at (key));
+            if (osm_convert::keep_value (unique_vals, key, kv_mat (count, ndi)))
+                osm_convert::set_utf8 (kv_mat, count, ndi, kv_iter->second);
         }
         count++;
     }
-    if (unique_vals.k_point.size () > 0)
-    {
-        kv_mat.attr ("dimnames") = Rcpp::List::create (ptnames, unique_vals.k_point);
-        kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
+    kv_mat.attr ("dimnames") = Rcpp::List::create (ptnames, cols.names ());
+    kv_df = kv_mat;
 
-        meta.attr ("dimnames") = Rcpp::List::create (ptnames, metanames);
-        meta_df = meta;
-    } else
-        kv_df = R_NilValue;
+    meta.attr ("dimnames") = Rcpp::List::create (ptnames, metanames);
+    meta_df = meta;
 
     ptList.attr ("names") = ptnames;
     ptnames.clear ();
-    ptList.attr ("n_empty") = 0;
-    ptList.attr ("class") = Rcpp::CharacterVector::create ("sfc_POINT", "sfc");
-    ptList.attr ("precision") = 0.0;
-    ptList.attr ("bbox") = bbox;
-    ptList.attr ("crs") = crs;
+    osm_sf::set_sfc_attributes (ptList, "POINT", bbox, crs, wkb);
+}
+
+//' set_sfc_attributes
+//'
+//' Set attributes of a list of geometries, either as an `sfc` object, or as a
+//' list of class "WKB" which is converted in R with `sf::st_as_sfc`.
+//'
+//' @param geomList Pointer to Rcpp::List of geometries
+//' @param geom_type Character string specifying the `sf` geometry type
+//' @param bbox Pointer to the bbox needed for `sf` construction
+//' @param crs Pointer to the crs needed for `sf` construction
+//' @param wkb If `true`, geometries are WKB raw vectors.
+//'
+//' @noRd
+void osm_sf::set_sfc_attributes (Rcpp::List &geomList,
+        const std::string &geom_type, const Rcpp::NumericVector &bbox,
+        const Rcpp::List &crs, const bool wkb)
+{
+    if (wkb)
+    {
+        geomList.attr ("class") = "WKB";
+        geomList.attr ("crs") = crs;
+        return;
+    }
+
+    geomList.attr ("n_empty") = 0;
+    geomList.attr ("class") =
+        Rcpp::CharacterVector::create ("sfc_" + geom_type, "sfc");
+    geomList.attr ("precision") = 0.0;
+    geomList.attr ("bbox") = bbox;
+    geomList.attr ("crs") = crs;
 }
 
 
@@ -513,11 +567,30 @@ void osm_sf::get_osm_nodes (Rcpp::List &ptList, Rcpp::DataFrame &kv_df, Rcpp::Da
 //' Return OSM data in Simple Features format
 //'
 //' @param st Text contents of an overpass API query
-//' @return Rcpp::List objects of OSM data
+//' @param merge_lines If `true`, contiguous member ways of multilinestring
+//'     relations are merged into single linestrings.
+//' @param resolve_relations If `true`, member ways of nested relations are
+//'     added to their parent relations.
+//' @param area_tags If `true`, closed ways are classified as polygons or
+//'     lines according to their tags, otherwise all closed ways are polygons.
+//' @param wkb If `true`, geometries are returned as lists of WKB raw vectors.
+//' @param factor_levels If positive, key-value columns with at most this number
+//' of distinct values are returned as factors.
+//' @param typed If `true`, key-value columns in which all values are logical,
+//' integer, or numeric are returned as such.
+//' @param units Named vector of factors by which to multiply numeric values
+//' with each unit suffix, when `typed` is `true`.
+//' @param id_type One of "character", "numeric", or "integer64", determining
+//' the type of "osm_id" columns.
+//' @return Rcpp::List objects of OSM data, with any keys renamed to avoid
+//' clashes with other columns in the "renamed_keys" attribute.
 //'
 //' @noRd
 // [[Rcpp::export]]
-Rcpp::List rcpp_osmdata_sf (const std::string& st)
+Rcpp::List rcpp_osmdata_sf (const std::string& st, const bool merge_lines,
+        const bool resolve_relations, const bool area_tags, const bool wkb,
+        const int factor_levels, const bool typed,
+        const Rcpp::NumericVector units, const std::string& id_type)
 {
 #ifdef DUMP_INPUT
     {
@@ -529,7 +602,9 @@ Rcpp::List rcpp_osmdata_sf (const std::string& st)
     }
 #endif
 
-    XmlData xml (st);
+    XmlData xml (st, area_tags);
+    if (resolve_relations)
+        xml.resolveRelations ();
 
     const std::map <osmid_t, Node>& nodes = xml.nodes ();
     const std::map <osmid_t, OneWay>& ways = xml.ways ();
@@ -564,7 +639,7 @@ Rcpp::List rcpp_osmdata_sf (const std::string& st)
      * --------------------------------------------------------------*/
 
     Rcpp::List tempList = osm_sf::get_osm_relations (rels, nodes, ways, unique_vals,
-            bbox, crs);
+            bbox, crs, merge_lines, wkb);
     Rcpp::List multipolygons = tempList [0];
     // the followin line errors because of ambiguous conversion
     //Rcpp::DataFrame kv_df_mp = tempList [1];
@@ -582,29 +657,21 @@ Rcpp::List rcpp_osmdata_sf (const std::string& st)
      * 3. Extract OSM ways
      * --------------------------------------------------------------*/
 
-    // first divide into polygonal and non-polygonal
-    std::set <osmid_t> poly_ways, non_poly_ways;
-    for (auto itw = ways.begin (); itw != ways.end (); ++itw)
-    {
-        if ((*itw).second.nodes.front () == (*itw).second.nodes.back ())
-        {
-            if (poly_ways.find ((*itw).first) == poly_ways.end ())
-                poly_ways.insert ((*itw).first);
-        } else if (non_poly_ways.find ((*itw).first) == non_poly_ways.end ())
-            non_poly_ways.insert ((*itw).first);
-    }
+    // Ways are divided into polygonal and non-polygonal at parse time
+    const WayIndex& poly_ways = xml.poly_ways ();
+    const WayIndex& non_poly_ways = xml.line_ways ();
 
     Rcpp::List polyList (poly_ways.size ());
     Rcpp::DataFrame kv_df_polys;
     Rcpp::DataFrame meta_df_polys;
     osm_sf::get_osm_ways (polyList, kv_df_polys, meta_df_polys,
-            poly_ways, ways, nodes, unique_vals, "POLYGON", bbox, crs);
+            poly_ways, nodes, unique_vals, "POLYGON", bbox, crs, wkb);
 
     Rcpp::List lineList (non_poly_ways.size ());
     Rcpp::DataFrame kv_df_lines;
     Rcpp::DataFrame meta_df_lines;
     osm_sf::get_osm_ways (lineList, kv_df_lines, meta_df_lines,
-            non_poly_ways, ways, nodes, unique_vals, "LINESTRING", bbox, crs);
+            non_poly_ways, nodes, unique_vals, "LINESTRING", bbox, crs, wkb);
 
     /* --------------------------------------------------------------
      * 3. Extract OSM nodes
@@ -618,7 +685,18 @@ Rcpp::List rcpp_osmdata_sf (const std::string& st)
     Rcpp::DataFrame kv_df_points;
     Rcpp::DataFrame meta_df_points;
     osm_sf::get_osm_nodes (pointList, kv_df_points, meta_df_points,
-            nodes, unique_vals, bbox, crs);
+            nodes, unique_vals, bbox, crs, wkb);
+
+    const osm_convert::UnitRules unit_rules = osm_convert::unit_rules (units);
+    for (SEXP kv_df: {SEXP (kv_df_points), SEXP (kv_df_lines),
+            SEXP (kv_df_polys), SEXP (kv_df_mp), SEXP (kv_df_ls)})
+    {
+        if (id_type != "character")
+            osm_convert::ids_to_numeric (kv_df, id_type == "integer64");
+        if (typed)
+            osm_convert::type_columns (kv_df, unit_rules);
+        osm_convert::factorise_columns (kv_df, factor_levels);
+    }
 
 
     /* --------------------------------------------------------------
@@ -649,5 +727,18 @@ Rcpp::List rcpp_osmdata_sf (const std::string& st)
         "multilines", "multilines_kv", "multilines_meta"};
     ret.attr ("names") = retnames;
 
+    // Keys renamed in each output by KvColumns::names, for a single warning
+    std::set <std::string> renamed;
+    osm_convert::rename_reserved (unique_vals.k_point_names,
+            osm_convert::sf_reserved, renamed);
+    osm_convert::rename_reserved (unique_vals.k_way_names,
+            osm_convert::sf_reserved, renamed);
+    osm_convert::rename_reserved (unique_vals.k_rel_names,
+            kv_df_ls.size () > 0 ? osm_convert::sf_reserved_ls :
+            osm_convert::sf_reserved, renamed);
+    if (renamed.size () > 0)
+        ret.attr ("renamed_keys") = osm_convert::utf8_vector (
+                std::vector <std::string> (renamed.begin (), renamed.end ()));
+
     return ret;
 }
@@ -57,7 +57,9 @@ void osm_sp::get_osm_nodes (Rcpp::S4 &sp_points, const Nodes &nodes,
 {
     Rcpp::NumericMatrix ptxy;
     Rcpp::CharacterMatrix kv_mat;
-    size_t nrow = nodes.size (), ncol = unique_vals.k_point.size ();
+    const osm_convert::KvColumns cols (unique_vals.k_point_names,
+            osm_convert::sp_reserved, false);
+    size_t nrow = nodes.size (), ncol = cols.ncol ();
 
     kv_mat = Rcpp::CharacterMatrix (Rcpp::Dimension (nrow, ncol));
     std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
@@ -72,14 +74,14 @@ void osm_sp::get_osm_nodes (Rcpp::S4 &sp_points, const Nodes &nodes,
         ptxy (count, 0) = ni->second.lon;
         ptxy (count, 1) = ni->second.lat;
         ptnames.push_back (std::to_string (ni->first));
+        osm_convert::set_utf8 (kv_mat, count, 0, ptnames.back ());
         for (auto kv_iter = ni->second.key_val.begin ();
                 kv_iter != ni->second.key_val.end (); ++kv_iter)
         {
             const std::string &key = kv_iter->first;
-            unsigned int ndi = static_cast <unsigned int> (
-                    std::distance (unique_vals.k_point.begin (),
-                        unique_vals.k_point.find (key)));
-            kv_mat (count, ndi) = kv_iter->second;
+            size_t ndi = cols.col (unique_vals.k_point_index.at (key));
+            if (osm_convert::keep_value (unique_vals, key, kv_mat (count, ndi)))
+                osm_convert::set_utf8 (kv_mat, count, ndi, kv_iter->second);
         }
         count++;
     }
@@ -90,13 +92,9 @@ void osm_sp::get_osm_nodes (Rcpp::S4 &sp_points, const Nodes &nodes,
     ptxy.attr ("dimnames") = dimnames;
     dimnames.erase (0, static_cast <int> (dimnames.size ()));
 
-    Rcpp::DataFrame kv_df = R_NilValue;
-    if (unique_vals.k_point.size () > 0)
-    {
-        kv_mat.attr ("dimnames") = Rcpp::List::create (ptnames, unique_vals.k_point);
-        kv_mat.attr ("names") = unique_vals.k_point;
-        kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
-    }
+    kv_mat.attr ("dimnames") = Rcpp::List::create (ptnames, cols.names ());
+    Rcpp::DataFrame kv_df;
+    kv_df = kv_mat;
 
     Rcpp::Language points_call ("new", "SpatialPoints");
     Rcpp::Language sp_points_call ("new", "SpatialPointsDataFrame");
@@ -112,8 +110,7 @@ void osm_sp::get_osm_nodes (Rcpp::S4 &sp_points, const Nodes &nodes,
 //'
 //' @param wayList Pointer to Rcpp::List to hold the resultant geometries
 //' @param kv_df Pointer to Rcpp::DataFrame to hold key-value pairs
-//' @param way_ids Vector of <osmid_t> IDs of ways to trace
-//' @param ways Pointer to all ways in data set
+//' @param way_index Vector of iterators to the ways to trace
 //' @param nodes Pointer to all nodes in data set
 //' @param unique_vals pointer to all unique values (OSM IDs and keys) in data set
 //' @param geom_type Character string specifying "POLYGON" or "LINESTRING"
@@ -121,27 +118,24 @@ void osm_sp::get_osm_nodes (Rcpp::S4 &sp_points, const Nodes &nodes,
 //' @param crs Pointer to the crs needed for `sf` construction
 //'
 //' @noRd
-void osm_sp::get_osm_ways (Rcpp::S4 &sp_ways,
-        const std::set <osmid_t> &way_ids, const Ways &ways, const Nodes &nodes,
-        const UniqueVals &unique_vals, const std::string &geom_type)
+void osm_sp::get_osm_ways (Rcpp::S4 &sp_ways, const WayIndex &way_index,
+        const Nodes &nodes, const UniqueVals &unique_vals,
+        const std::string &geom_type)
 {
     const int one = static_cast <int> (1);
 
     if (!(geom_type == "line" || geom_type == "polygon"))
         throw std::runtime_error ("geom_type must be line or polygon");
 
-    Rcpp::List wayList (way_ids.size ());
+    Rcpp::List wayList (way_index.size ());
 
-    size_t nrow = way_ids.size (), ncol = unique_vals.k_way.size ();
+    const osm_convert::KvColumns cols (unique_vals.k_way_names,
+            osm_convert::sp_reserved, false);
+    size_t nrow = way_index.size (), ncol = cols.ncol ();
     std::vector <std::string> waynames;
-    waynames.reserve (way_ids.size ());
+    waynames.reserve (way_index.size ());
 
-    Rcpp::Language line_call ("new", "Line");
-    Rcpp::Language lines_call ("new", "Lines");
-    Rcpp::Environment sp_env = Rcpp::Environment::namespace_env ("sp");
-    Rcpp::Function Polygon = sp_env ["Polygon"];
-    Rcpp::Language polygons_call ("new", "Polygons");
-    Rcpp::S4 polygons, line, lines;
+    const osm_convert::SpPrototypes proto;
 
     // index of ill-formed polygons later removed - see issue#85
     std::vector <unsigned int> indx_out;
@@ -150,13 +144,12 @@ void osm_sp::get_osm_ways (Rcpp::S4 &sp_ways,
     Rcpp::CharacterMatrix kv_mat (Rcpp::Dimension (nrow, ncol));
     std::fill (kv_mat.begin (), kv_mat.end (), NA_STRING);
     unsigned int count = 0;
-    for (auto wi = way_ids.begin (); wi != way_ids.end (); ++wi)
+    for (auto wj: way_index)
     {
         Rcpp::checkUserInterrupt ();
-        waynames.push_back (std::to_string (*wi));
+        waynames.push_back (std::to_string (wj->first));
         Rcpp::NumericMatrix nmat;
-        osm_convert::trace_way_nmat (ways, nodes, (*wi), nmat);
-        Rcpp::List dummy_list (0);
+        osm_convert::trace_way_nmat (wj, nodes, nmat);
         poly_okay [count] = true;
         if (geom_type == "line")
         {
@@ -165,14 +158,10 @@ void osm_sp::get_osm_ways (Rcpp::S4 &sp_ways,
             // slower:
             // Rcpp::S4 line = Rcpp::Language ("Line", nmat).eval ();
             // Rcpp::S4 lines = Rcpp::Language ("Lines", line, id).eval ();
-            // This way of constructing "new" objects and feeding slots is much
-            // faster:
-            line = line_call.eval ();
-            line.slot ("coords") = nmat;
-            dummy_list.push_back (line);
-            lines = lines_call.eval ();
-            lines.slot ("Lines") = dummy_list;
-            lines.slot ("ID") = (*wi);
+            // Even evaluating 'new' for each object is slow, so objects are
+            // copied from prototypes and their slots filled directly:
+            Rcpp::S4 lines = proto.lines (Rcpp::List::create (proto.line (nmat)));
+            lines.slot ("ID") = wj->first;
             wayList [count] = lines;
         } else
         {
@@ -189,21 +178,13 @@ void osm_sp::get_osm_ways (Rcpp::S4 &sp_ways,
                 nmat = nmat2;
             }
 
-            Rcpp::S4 poly = Polygon (nmat);
-            poly.slot ("hole") = false;
-            poly.slot ("ringDir") = one;
-            dummy_list.push_back (poly);
-            polygons = polygons_call.eval ();
-            polygons.slot ("Polygons") = dummy_list;
-            polygons.slot ("ID") = (*wi);
+            Rcpp::S4 polygons = proto.polygons (
+                    Rcpp::List::create (proto.polygon (nmat, false, one)));
+            polygons.slot ("ID") = wj->first;
             polygons.slot ("plotOrder") = one;
-            polygons.slot ("labpt") = poly.slot ("labpt");
-            polygons.slot ("area") = poly.slot ("area");
             wayList [count] = polygons;
         }
-        dummy_list.erase (0);
-        auto wj = ways.find (*wi);
-        osm_convert::get_value_mat_way (wj, unique_vals, kv_mat, count++);
+        osm_convert::get_value_mat_way (wj, unique_vals, cols, kv_mat, count++);
     } // end for it over poly_ways
     if (indx_out.size () > 0)
     {
@@ -234,14 +215,10 @@ void osm_sp::get_osm_ways (Rcpp::S4 &sp_ways,
     }
 
     Rcpp::DataFrame kv_df = R_NilValue;
-    if (way_ids.size () > 0)
+    if (way_index.size () > 0)
     {
-        kv_mat.attr ("names") = unique_vals.k_way;
-        kv_mat.attr ("dimnames") = Rcpp::List::create (waynames, unique_vals.k_way);
-        kv_mat.attr ("names") = unique_vals.k_way;
-        if (kv_mat.nrow () > 0 && kv_mat.ncol () > 0)
-            kv_df = osm_convert::restructure_kv_mat (kv_mat, false);
-        // TODO: Can names be assigned to R_NilValue?
+        kv_mat.attr ("dimnames") = Rcpp::List::create (waynames, cols.names ());
+        kv_df = kv_mat;
     }
 
     if (geom_type == "line")
@@ -322,13 +299,11 @@ void osm_sp::get_osm_relations (Rcpp::S4 &multilines, Rcpp::S4 &multipolygons,
         }
     }
 
-    size_t ncol = unique_vals.k_rel.size ();
     rel_id_mp.reserve (nmp);
     rel_id_ls.reserve (nls);
 
-    Rcpp::CharacterMatrix kv_mat_mp (Rcpp::Dimension (nmp, ncol)),
-        kv_mat_ls (Rcpp::Dimension (nls, ncol));
-    unsigned int count_mp = 0, count_ls = 0;
+    // Key-value data are filled in 'convert_multipoly_to_sp' and
+    // 'convert_multiline_to_sp'
 
     for (auto itr = rels.begin (); itr != rels.end (); ++itr)
     {
@@ -352,9 +327,6 @@ void osm_sp::get_osm_relations (Rcpp::S4 &multilines, Rcpp::S4 &multipolygons,
             rowname_vec.shrink_to_fit ();
             ids_mp.clear ();
             ids_mp.shrink_to_fit ();
-
-            if (nmp > 0)
-                osm_convert::get_value_mat_rel (itr, unique_vals, kv_mat_mp, count_mp++);
         } else // store as multilinestring
         {
             // multistrings are grouped here by roles, unlike GDAL which just
@@ -390,9 +362,6 @@ void osm_sp::get_osm_relations (Rcpp::S4 &multilines, Rcpp::S4 &multipolygons,
                 rowname_vec.shrink_to_fit ();
                 ids_ls.clear ();
                 ids_ls.shrink_to_fit ();
-
-                if (nls > 0)
-                    osm_convert::get_value_mat_rel (itr, unique_vals, kv_mat_ls, count_ls++);
             }
             roles_ls.push_back (roles);
             roles.clear ();
@@ -433,6 +402,8 @@ void osm_sp::get_osm_relations (Rcpp::S4 &multilines, Rcpp::S4 &multipolygons,
 //'
 //' @param st Text contents of an overpass API query
 //' @return A \code{SpatialLinesDataFrame} contains all polygons and associated data
+//' (any keys renamed to avoid clashes with other columns are in the
+//' "renamed_keys" attribute).
 //'
 //' @noRd
 // [[Rcpp::export]]
@@ -464,17 +435,9 @@ Rcpp::List rcpp_osmdata_sp (const std::string& st)
      ************************************************************************
      ************************************************************************/
 
-    // Step#2
-    std::set <osmid_t> poly_ways, non_poly_ways;
-    for (auto itw = ways.begin (); itw != ways.end (); ++itw)
-    {
-        if ((*itw).second.nodes.front () == (*itw).second.nodes.back ())
-        {
-            if (poly_ways.find ((*itw).first) == poly_ways.end ())
-                poly_ways.insert ((*itw).first);
-        } else if (non_poly_ways.find ((*itw).first) == non_poly_ways.end ())
-            non_poly_ways.insert ((*itw).first);
-    }
+    // Step#2: Ways are divided into polygonal and non-polygonal at parse time
+    const WayIndex& poly_ways = xml.poly_ways ();
+    const WayIndex& non_poly_ways = xml.line_ways ();
 
     /************************************************************************
      ************************************************************************
@@ -486,8 +449,8 @@ Rcpp::List rcpp_osmdata_sp (const std::string& st)
 
     // The actual routines to extract the OSM data and store in sp objects
     Rcpp::S4 sp_points, sp_lines, sp_polygons, sp_multilines, sp_multipolygons;
-    osm_sp::get_osm_ways (sp_polygons, poly_ways, ways, nodes, unique_vals, "polygon");
-    osm_sp::get_osm_ways (sp_lines, non_poly_ways, ways, nodes, unique_vals, "line");
+    osm_sp::get_osm_ways (sp_polygons, poly_ways, nodes, unique_vals, "polygon");
+    osm_sp::get_osm_ways (sp_lines, non_poly_ways, nodes, unique_vals, "line");
     osm_sp::get_osm_nodes (sp_points, nodes, unique_vals);
     osm_sp::get_osm_relations (sp_multilines, sp_multipolygons,
             rels, nodes, ways, unique_vals);
@@ -522,5 +485,13 @@ Rcpp::List rcpp_osmdata_sp (const std::string& st)
         "multilines", "multipolygons"};
     ret.attr ("names") = retnames;
 
+    std::set <std::string> renamed;
+    for (const auto *k: {&unique_vals.k_point_names, &unique_vals.k_way_names,
+            &unique_vals.k_rel_names})
+        osm_convert::rename_reserved (*k, osm_convert::sp_reserved, renamed);
+    if (renamed.size () > 0)
+        ret.attr ("renamed_keys") = osm_convert::utf8_vector (
+                std::vector <std::string> (renamed.begin (), renamed.end ()));
+
     return ret;
 }
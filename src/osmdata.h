@@ -36,6 +36,11 @@
 #include "get-bbox.h"
 #include "trace-osm.h"
 #include "convert-osm-rcpp.h"
+#include "arrow-ipc.h"
+
+#include <array>
+#include <cctype>
+#include <unordered_map>
 
 // sf::st_crs(4326)$wkt
 const std::string wkt =
@@ -86,12 +91,14 @@ const Rcpp::CharacterVector centernames = {"_lat", "_lon"};
  *      3b. get_value_mat_way ()
  *      3c. get_value_mat_rel ()
  *      3d. convert_poly_linestring_to_Rcpp ()
- *      3e. restructure_kv_mat ()
+ *      3e. KvColumns (columns of key-value matrices)
  * 4. osmdata.cpp
  *      5c. get_osm_relations ()
  *      5d. get_osm_ways ()
  *      5e. get_osm_nodes ()
  *      5a. rcpp_osmdata () - The final Rcpp function called by osmdata_sf
+ * 5. arrow-ipc.h = Minimal writer of Arrow IPC files (pure C++), used in
+ *      osmdata-arrow.cpp to write GeoArrow data directly from XmlData
  *
  * ----------------------------------------------------------------------
  *
@@ -101,10 +108,8 @@ const Rcpp::CharacterVector centernames = {"_lat", "_lon"};
  *      {
  *          -> trace_multipolygon ()
  *              -> trace_way ()
- *              -> restructure_kv_mat
  *          -> trace_multilinestring ()
  *              -> trace_way ()
- *              -> restructure_kv_mat
  *          -> get_value_vec ()
  *          -> convert_poly_linestring_to_Rcpp ()
  *          -> [... most check and clean functions ...]
@@ -113,10 +118,8 @@ const Rcpp::CharacterVector centernames = {"_lat", "_lon"};
  *      {
  *          -> trace_way_nmat ()
  *          -> get_value_mat_way ()
- *          -> restructure_kv_mat
  *      }
  *      -> get_osm_nodes ()
- *          -> restructure_kv_mat
  *  }
  */
 
@@ -137,18 +140,22 @@ class XmlData
         Ways m_ways;
         Relations m_relations;
         UniqueVals m_unique;
+        WayIndex m_poly_ways, m_line_ways;
+        bool m_area_tags;
 
     public:
 
         double xmin = DOUBLE_MAX, xmax = -DOUBLE_MAX,
               ymin = DOUBLE_MAX, ymax = -DOUBLE_MAX;
 
-        XmlData (const std::string& str)
+        XmlData (const std::string& str, const bool area_tags = false)
+            : m_area_tags (area_tags)
         {
             // APS empty m_nodes/m_ways/m_relations constructed here, no need to explicitly clear
             XmlDocPtr p = parseXML (str);
             traverseWays (p->first_node ());
             make_key_val_indices ();
+            make_way_indices ();
         }
 
         // APS make the dtor virtual since compiler support for "final" is limited
@@ -162,18 +169,34 @@ class XmlData
         const Ways& ways() const { return m_ways; }
         const Relations& relations() const { return m_relations; }
         const UniqueVals& unique_vals() const { return m_unique; }
+        const WayIndex& poly_ways() const { return m_poly_ways; }
+        const WayIndex& line_ways() const { return m_line_ways; }
         double x_min() { return xmin;  }
         double x_max() { return xmax;  }
         double y_min() { return ymin;  }
         double y_max() { return ymax;  }
 
+        void resolveRelations ();
+
     private:
 
+        // Members of relations resolved by 'resolveRelations', and resolved
+        // 'ispoly' flags, both indexed by relation ID.
+        typedef std::unordered_map <osmid_t,
+                std::vector <std::pair <osmid_t, std::string> > > RelWayMap;
+        typedef std::unordered_map <osmid_t, bool> RelPolyMap;
+
         void traverseWays (XmlNodePtr pt);
         void traverseRelation (XmlNodePtr pt, RawRelation& rrel);
         void traverseWay (XmlNodePtr pt, RawWay& rway);
         void traverseNode (XmlNodePtr pt, RawNode& rnode);
         void make_key_val_indices ();
+        void make_way_indices ();
+        bool is_area (const OneWay &way) const;
+        void resolveRelation (const size_t i,
+                const std::unordered_map <osmid_t, size_t> &rel_index,
+                RelWayMap &rel_ways, RelPolyMap &rel_poly,
+                std::unordered_set <osmid_t> &in_progress);
 
 }; // end Class::XmlData
 
@@ -269,6 +292,7 @@ inline void XmlData::traverseWays (XmlNodePtr pt)
 
                 // Then copy nodes from rway to way.
                 way.nodes.swap (rway.nodes);
+                way.ispoly = is_area (way);
                 m_ways.insert (std::make_pair (way.id, way));
             }
         }
@@ -278,8 +302,10 @@ inline void XmlData::traverseWays (XmlNodePtr pt)
             rrel.value.clear();
             rrel.role_way.clear();
             rrel.role_node.clear();
+            rrel.role_relation.clear();
             rrel.ways.clear();
             rrel.nodes.clear();
+            rrel.relations.clear();
             rrel.member_type = "";
             rrel.ispoly = false;
 
@@ -290,6 +316,8 @@ inline void XmlData::traverseWays (XmlNodePtr pt)
                 throw std::runtime_error ("size of ways and roles differ");
             if (rrel.nodes.size () != rrel.role_node.size ())
                 throw std::runtime_error ("size of nodes and roles differ");
+            if (rrel.relations.size () != rrel.role_relation.size ())
+                throw std::runtime_error ("size of relations and roles differ");
 
             if (m_unique.id_rel.find (rrel.id) == m_unique.id_rel.end ())
             {
@@ -297,6 +325,8 @@ inline void XmlData::traverseWays (XmlNodePtr pt)
                 relation.id = rrel.id;
                 relation.key_val.clear();
                 relation.ways.clear();
+                relation.nodes.clear();
+                relation.relations.clear();
                 relation.ispoly = rrel.ispoly;
                 for (size_t i=0; i<rrel.key.size (); i++)
                 {
@@ -312,6 +342,9 @@ inline void XmlData::traverseWays (XmlNodePtr pt)
                 for (size_t i=0; i<rrel.nodes.size (); i++)
                     relation.nodes.push_back (std::make_pair (rrel.nodes [i],
                                 rrel.role_node [i]));
+                for (size_t i=0; i<rrel.relations.size (); i++)
+                    relation.relations.push_back (std::make_pair (
+                                rrel.relations [i], rrel.role_relation [i]));
                 // metadata:
                 relation._version = rrel._version;
                 relation._changeset = rrel._changeset;
@@ -491,19 +524,221 @@ inline void XmlData::traverseNode (XmlNodePtr pt, RawNode& rnode)
 
 inline void XmlData::make_key_val_indices ()
 {
-    // These are std::maps which enable keys to be mapped directly onto their
-    // column number in the key-val matrices
-    unsigned int i = 0;
-    for (auto m: m_unique.k_point)
-        m_unique.k_point_index.insert (std::make_pair (m, i++));
-
-    i = 0;
-    for (auto m: m_unique.k_way)
-        m_unique.k_way_index.insert (std::make_pair (m, i++));
-
-    i = 0;
-    for (auto m: m_unique.k_rel)
-        m_unique.k_rel_index.insert (std::make_pair (m, i++));
+    // Keys which differ only in case are resolved once over the keys of all
+    // object types, so that they share the same column in every output. Keys
+    // which clash with other columns are renamed by each converter, because
+    // those columns differ between outputs.
+    auto to_lower = [] (std::string s) {
+        for (auto &c: s)
+            c = static_cast <char> (std::tolower (static_cast <unsigned char> (c)));
+        return s;
+    };
+
+    std::set <std::string> keys (m_unique.k_point);
+    keys.insert (m_unique.k_way.begin (), m_unique.k_way.end ());
+    keys.insert (m_unique.k_rel.begin (), m_unique.k_rel.end ());
+
+    // Lower-case keys mapped to the names of their columns
+    std::unordered_map <std::string, std::string> lower_names;
+    m_unique.k_names.reserve (keys.size ());
+
+    auto add_key = [&] (const std::string &key) {
+        auto it = lower_names.emplace (to_lower (key), key);
+        if (!it.second)
+            m_unique.k_merged.insert (key);
+        m_unique.k_names.emplace (key, it.first->second);
+    };
+
+    // "name" is moved to the front of key-val matrices, and so takes
+    // precedence over other cases, which otherwise follow alphabetical order.
+    if (keys.count ("name") > 0)
+        add_key ("name");
+    for (const auto &k: keys)
+        if (k != "name")
+            add_key (k);
+
+    // These are hash maps which enable keys to be mapped directly onto their
+    // column number in the key-val matrices. Any "name" column is always
+    // first, so that it directly follows "osm_id" in 'sf' and 'sp' outputs.
+    auto index_keys = [&] (const std::set <std::string> &k,
+            std::unordered_map <std::string, unsigned int> &index,
+            std::vector <std::string> &names) {
+        index.reserve (k.size ());
+        std::unordered_map <std::string, unsigned int> cols;
+        auto add_col = [&] (const std::string &m) {
+            const std::string &name = m_unique.k_names.at (m);
+            auto it = cols.emplace (name,
+                    static_cast <unsigned int> (names.size ()));
+            if (it.second)
+                names.push_back (name);
+            index.emplace (m, it.first->second);
+        };
+        for (const auto &m: k)
+            if (m_unique.k_names.at (m) == "name")
+                add_col (m);
+        for (const auto &m: k)
+            if (m_unique.k_names.at (m) != "name")
+                add_col (m);
+    };
+
+    index_keys (m_unique.k_point, m_unique.k_point_index,
+            m_unique.k_point_names);
+    index_keys (m_unique.k_way, m_unique.k_way_index, m_unique.k_way_names);
+    index_keys (m_unique.k_rel, m_unique.k_rel_index, m_unique.k_rel_names);
+}
+
+inline void XmlData::make_way_indices ()
+{
+    // Single pass in order of way IDs, with classification already done by
+    // 'is_area' at parse time.
+    for (auto itw = m_ways.cbegin (); itw != m_ways.cend (); ++itw)
+    {
+        if (itw->second.ispoly)
+            m_poly_ways.push_back (itw);
+        else
+            m_line_ways.push_back (itw);
+    }
+}
+
+/* Classify a way as polygonal or not. By default, all closed ways are
+ * polygons. If 'm_area_tags' is set, closed ways are also classified by their
+ * tags, following the usual OSM conventions (see
+ * https://wiki.openstreetmap.org/wiki/Key:area): 'area=yes/no' always takes
+ * precedence, then keys which are generally areas, then keys which are
+ * generally linear (so closed highways, barriers, and the like are lines).
+ * Closed ways with none of these keys remain polygons.
+ */
+inline bool XmlData::is_area (const OneWay &way) const
+{
+    if (way.nodes.size () == 0 || way.nodes.front () != way.nodes.back ())
+        return false;
+    if (!m_area_tags)
+        return true;
+
+    const std::map <std::string, std::string> &kv = way.key_val;
+    auto a = kv.find ("area");
+    if (a != kv.end ())
+    {
+        if (a->second == "yes")
+            return true;
+        else if (a->second == "no")
+            return false;
+    }
+
+    static const std::vector <std::string> area_keys = {"amenity", "building",
+        "building:part", "landuse", "leisure", "place", "shop", "tourism"};
+    for (auto k: area_keys)
+        if (kv.find (k) != kv.end ())
+            return true;
+
+    auto w = kv.find ("waterway");
+    if (w != kv.end () && (w->second == "riverbank" || w->second == "dock"))
+        return true;
+    auto n = kv.find ("natural");
+    if (n != kv.end () && n->second == "coastline")
+        return false;
+    auto p = kv.find ("power");
+    if (p != kv.end () && (p->second == "line" || p->second == "minor_line" ||
+                p->second == "cable"))
+        return false;
+
+    static const std::vector <std::string> line_keys = {"aerialway",
+        "barrier", "highway", "railway", "route", "waterway"};
+    for (auto k: line_keys)
+        if (kv.find (k) != kv.end ())
+            return false;
+
+    return true;
+}
+
+
+/************************************************************************
+ ************************************************************************
+ **                                                                    **
+ **                     FUNCTION::RESOLVERELATIONS                     **
+ **                                                                    **
+ ************************************************************************
+ ************************************************************************/
+
+/* Relations may have other relations as members (route masters, boundary
+ * hierarchies, site relations, ...). This optional pass appends the member
+ * ways of all nested relations (at any depth) to the ways of each parent
+ * relation, so they can be traced as geometries like any other relation.
+ * Sub-relations which are not in the data set are ignored.
+ *
+ * Results are memoised by relation ID, so each relation is resolved only once
+ * however many parents it has. Cycles are broken by ignoring any member
+ * relation which is still being resolved higher up the current chain.
+ *
+ * Member ways retain their roles in the sub-relations. Ways already present
+ * in a relation are not added again. Polygonal relations which have their own
+ * member ways are left as they are, because these already define the full
+ * geometry (for example, a country boundary with sub-area members).
+ * Relations with no member ways of their own become polygonal if all of their
+ * resolved sub-relations are polygonal.
+ */
+inline void XmlData::resolveRelations ()
+{
+    std::unordered_map <osmid_t, size_t> rel_index;
+    for (size_t i = 0; i < m_relations.size (); i++)
+        rel_index.emplace (m_relations [i].id, i);
+
+    RelWayMap rel_ways;
+    RelPolyMap rel_poly;
+    std::unordered_set <osmid_t> in_progress;
+    for (size_t i = 0; i < m_relations.size (); i++)
+        resolveRelation (i, rel_index, rel_ways, rel_poly, in_progress);
+
+    for (auto &r: m_relations)
+    {
+        r.ways.swap (rel_ways.at (r.id));
+        r.ispoly = rel_poly.at (r.id);
+    }
+}
+
+inline void XmlData::resolveRelation (const size_t i,
+        const std::unordered_map <osmid_t, size_t> &rel_index,
+        RelWayMap &rel_ways, RelPolyMap &rel_poly,
+        std::unordered_set <osmid_t> &in_progress)
+{
+    const Relation &rel = m_relations [i];
+    if (rel_ways.find (rel.id) != rel_ways.end ())
+        return;
+
+    std::vector <std::pair <osmid_t, std::string> > ways = rel.ways;
+    bool ispoly = rel.ispoly;
+    if (rel.relations.size () > 0 && !(rel.ispoly && rel.ways.size () > 0))
+    {
+        in_progress.insert (rel.id);
+
+        std::unordered_set <osmid_t> way_ids;
+        for (auto w: rel.ways)
+            way_ids.insert (w.first);
+
+        bool all_poly = true, any_sub = false;
+        for (auto r: rel.relations)
+        {
+            auto ri = rel_index.find (r.first);
+            if (ri == rel_index.end () ||
+                    in_progress.find (r.first) != in_progress.end ())
+                continue;
+
+            resolveRelation (ri->second, rel_index, rel_ways, rel_poly,
+                    in_progress);
+            any_sub = true;
+            all_poly = all_poly && rel_poly.at (r.first);
+            for (auto w: rel_ways.at (r.first))
+                if (way_ids.insert (w.first).second)
+                    ways.push_back (w);
+        }
+        if (rel.ways.size () == 0 && any_sub)
+            ispoly = all_poly;
+
+        in_progress.erase (rel.id);
+    }
+
+    rel_ways.emplace (rel.id, ways);
+    rel_poly.emplace (rel.id, ispoly);
 }
 
 /*---------------------------- fn headers -----------------------------*/
@@ -513,28 +748,36 @@ namespace osm_sf {
 Rcpp::List get_osm_relations (const Relations &rels,
         const std::map <osmid_t, Node> &nodes,
         const std::map <osmid_t, OneWay> &ways, const UniqueVals &unique_vals,
-        const Rcpp::NumericVector &bbox, const Rcpp::List &crs);
+        const Rcpp::NumericVector &bbox, const Rcpp::List &crs,
+        const bool merge_lines, const bool wkb);
 void get_osm_ways (Rcpp::List &wayList, Rcpp::DataFrame &kv_df,
-        Rcpp::DataFrame &meta_df,
-        const std::set <osmid_t> &way_ids, const Ways &ways, const Nodes &nodes,
+        Rcpp::DataFrame &meta_df, const WayIndex &way_index, const Nodes &nodes,
         const UniqueVals &unique_vals, const std::string &geom_type,
-        const Rcpp::NumericVector &bbox, const Rcpp::List &crs);
+        const Rcpp::NumericVector &bbox, const Rcpp::List &crs,
+        const bool wkb);
 void get_osm_nodes (Rcpp::List &ptList, Rcpp::DataFrame &kv_df,
         Rcpp::DataFrame &meta_df,
         const Nodes &nodes, const UniqueVals &unique_vals,
-        const Rcpp::NumericVector &bbox, const Rcpp::List &crs);
+        const Rcpp::NumericVector &bbox, const Rcpp::List &crs,
+        const bool wkb);
+void set_sfc_attributes (Rcpp::List &geomList, const std::string &geom_type,
+        const Rcpp::NumericVector &bbox, const Rcpp::List &crs,
+        const bool wkb);
 
 } // end namespace osm_sf
 
-Rcpp::List rcpp_osmdata_sf (const std::string& st);
+Rcpp::List rcpp_osmdata_sf (const std::string& st, const bool merge_lines,
+        const bool resolve_relations, const bool area_tags, const bool wkb,
+        const int factor_levels, const bool typed,
+        const Rcpp::NumericVector units, const std::string& id_type);
 
 namespace osm_sp {
 
 void get_osm_nodes (Rcpp::S4 &sp_points, const Nodes &nodes,
         const UniqueVals &unique_vals);
-void get_osm_ways (Rcpp::S4 &sp_ways,
-        const std::set <osmid_t> &way_ids, const Ways &ways, const Nodes &nodes,
-        const UniqueVals &unique_vals, const std::string &geom_type);
+void get_osm_ways (Rcpp::S4 &sp_ways, const WayIndex &way_index,
+        const Nodes &nodes, const UniqueVals &unique_vals,
+        const std::string &geom_type);
 void get_osm_relations (Rcpp::S4 &multilines, Rcpp::S4 &multipolygons,
         const Relations &rels, const std::map <osmid_t, Node> &nodes,
         const std::map <osmid_t, OneWay> &ways, const UniqueVals &unique_vals);
@@ -555,17 +798,182 @@ void get_osm_nodes (Rcpp::DataFrame &node_df, Rcpp::DataFrame &kv_df,
 
 } // end namespace osm_sc
 
-Rcpp::List rcpp_osmdata_sc (const std::string& st);
+Rcpp::List rcpp_osmdata_sc (const std::string& st, const std::string& id_type,
+        const bool lengths);
+
+template <typename id_t> class XmlDataSC;
+
+namespace osm_graph {
+
+std::unordered_set <osmid_t> select_ways (const XmlDataSC <osmid_t> &xml,
+        const std::string &key, const std::vector <std::string> &values);
+
+} // end namespace osm_graph
+
+Rcpp::List rcpp_osm_graph (const std::string& st, const std::string& key,
+        const std::vector <std::string>& values, const bool directed,
+        const bool way_index, const bool lengths);
+
+namespace sc_methods {
+
+std::vector <uint64_t> column_keys (SEXP col);
+
+// Hash and equality of table rows identified by their indices, with values
+// given by 'column_keys' for each column.
+struct RowHash
+{
+    const std::vector <std::vector <uint64_t> > &keys;
+    RowHash (const std::vector <std::vector <uint64_t> > &k) : keys (k) {}
+    size_t operator() (const size_t row) const;
+};
+
+struct RowEqual
+{
+    const std::vector <std::vector <uint64_t> > &keys;
+    RowEqual (const std::vector <std::vector <uint64_t> > &k) : keys (k) {}
+    bool operator() (const size_t a, const size_t b) const;
+};
+
+// Keys of edges from 'column_keys' of both vertices and the object, and a flag
+// for whether the object is known.
+typedef std::array <uint64_t, 4> EdgeKey;
+struct EdgeHash
+{
+    size_t operator() (const EdgeKey &k) const;
+};
+
+SEXP list_elt (SEXP x, const std::string &name);
+R_xlen_t table_nrow (SEXP tab);
+void remap_edges (const Rcpp::List &x, Rcpp::List &edge_ids,
+        Rcpp::List &oxe_ids);
+SEXP bind_unique (const std::vector <SEXP> &parts,
+        const std::vector <std::string> &keys, const std::string &repl_name,
+        const Rcpp::List &repl);
+
+std::vector <bool> points_in_poly (const std::vector <double> &x,
+        const std::vector <double> &y, const std::vector <double> &px,
+        const std::vector <double> &py);
+std::vector <bool> index_flags (const Rcpp::IntegerVector &index,
+        const std::vector <bool> &flags);
+int trace_chain (const int e, const int new_edge,
+        const std::vector <int> &v0, const std::vector <int> &v1,
+        const std::vector <bool> &contractible,
+        const std::vector <int> &out_edge, std::vector <int> &edge_map);
+
+} // end namespace sc_methods
+
+Rcpp::List rcpp_sc_c (const Rcpp::List x, const Rcpp::CharacterVector tables);
+Rcpp::List rcpp_sc_trim (const Rcpp::NumericVector x,
+        const Rcpp::NumericVector y, const Rcpp::NumericMatrix poly,
+        const Rcpp::List index, const int n_objects, const int n_relations,
+        const bool exclude);
+Rcpp::List rcpp_sc_contract (const Rcpp::IntegerVector v0,
+        const Rcpp::IntegerVector v1, const Rcpp::IntegerVector object,
+        const int n_vertices, const Rcpp::NumericVector d);
+Rcpp::List rcpp_sc_elevation (const Rcpp::CharacterVector files,
+        const Rcpp::NumericVector x, const Rcpp::NumericVector y,
+        const Rcpp::IntegerVector v0, const Rcpp::IntegerVector v1);
 
 namespace osm_df {
 
-Rcpp::List get_osm_relations (const Relations &rels,
-        const UniqueVals &unique_vals);
-Rcpp::List get_osm_ways (const std::set <osmid_t> &way_ids,
-        const Ways &ways, const UniqueVals &unique_vals);
-Rcpp::List get_osm_nodes (const Nodes &nodes,
-        const UniqueVals &unique_vals);
+const size_t n_meta = 5; // version, timestamp, changeset, uid, user
+
+// Columns of the final data.frame, each allocated once for all objects
+struct Columns
+{
+    Rcpp::CharacterVector osm_type, osm_id;
+    Rcpp::NumericVector center_lat, center_lon, timestamp;
+    std::vector <Rcpp::CharacterVector> meta; // all except timestamp
+    bool has_meta [n_meta] = {};
+    std::vector <Rcpp::CharacterVector> tags;
+    std::vector <std::string> tag_names;
+    std::unordered_map <std::string, unsigned int> key_index; // key -> tags
+    const UniqueVals &unique_vals;
+
+    Columns (const size_t nrow, const std::set <std::string> &keys,
+            const UniqueVals &unique_vals);
+};
+
+bool get_osm_relations (const Relations &rels, Columns &cols,
+        unsigned int &row);
+bool get_osm_ways (const Ways &ways, Columns &cols, unsigned int &row);
+bool get_osm_nodes (const Nodes &nodes, Columns &cols, unsigned int &row);
 
 } // end namespace osm_df
 
-Rcpp::List rcpp_osmdata_df (const std::string& st);
+Rcpp::List rcpp_osmdata_df (const std::string& st, const int factor_levels,
+        const bool typed, const Rcpp::NumericVector units);
+
+namespace osm_adiff {
+
+const size_t n_meta = 5; // version, timestamp, changeset, uid, user
+
+// One version of one object in an augmented diff
+struct Change
+{
+    std::string type, id, action;
+    bool is_new = true;
+    int visible = NA_LOGICAL;
+    double lat = NA_REAL, lon = NA_REAL; // coordinates of nodes, or centers
+    bool has_center = false, has_latlon = false;
+    std::string meta [n_meta];
+    bool has_meta [n_meta] = {};
+    std::vector <std::pair <std::string, std::string> > tags;
+    // Coordinates of ways, or of all member ways of relations
+    std::vector <std::vector <double> > x, y;
+};
+
+void read_object (XmlNodePtr pt, const std::string &action, const bool is_new,
+        std::vector <Change> &changes);
+void read_action (XmlNodePtr pt, std::vector <Change> &changes);
+Rcpp::RawVector wkb_geometry (const Change &ch, std::string &geom_type);
+
+} // end namespace osm_adiff
+
+Rcpp::List rcpp_osmdata_adiff (const std::string& st, const bool geometry);
+
+namespace osm_csv {
+
+enum class ColType { character, integer, real };
+
+// Offset and length of one value within Table::buf; empty values are NA.
+struct Field
+{
+    size_t offset, len;
+};
+
+struct Table
+{
+    std::string buf;
+    std::vector <std::string> names;
+    std::vector <std::vector <Field> > cols;
+    size_t nrow = 0;
+};
+
+void parse (const std::string &st, const bool header, Table &tab);
+ColType infer_type (const Table &tab, const size_t j);
+
+} // end namespace osm_csv
+
+Rcpp::List rcpp_osmdata_csv (const std::string& st, const bool header,
+        const bool typed);
+
+namespace osm_arrow {
+
+void get_osm_relations (const Relations &rels, const Ways &ways,
+        const Nodes &nodes, const bool merge_lines, const bool interleaved,
+        std::vector <arrow_ipc::Column> &multipolygons,
+        std::vector <arrow_ipc::Column> &multilines,
+        std::set <std::string> &renamed);
+std::vector <arrow_ipc::Column> get_osm_ways (const WayIndex &way_index,
+        const Nodes &nodes, const std::string &geom_type,
+        const bool interleaved, std::set <std::string> &renamed);
+std::vector <arrow_ipc::Column> get_osm_nodes (const Nodes &nodes,
+        const bool interleaved, std::set <std::string> &renamed);
+
+} // end namespace osm_arrow
+
+Rcpp::CharacterVector rcpp_osmdata_arrow (const std::string& st,
+        const std::string& path, const bool merge_lines,
+        const bool resolve_relations, const bool area_tags,
+        const bool interleaved, const bool stream);
@@ -8,16 +8,32 @@
 */
 
 /* .Call calls */
-extern SEXP _osmdata_rcpp_osmdata_df(SEXP);
-extern SEXP _osmdata_rcpp_osmdata_sc(SEXP);
-extern SEXP _osmdata_rcpp_osmdata_sf(SEXP);
+extern SEXP _osmdata_rcpp_osm_graph(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _osmdata_rcpp_osmdata_adiff(SEXP, SEXP);
+extern SEXP _osmdata_rcpp_osmdata_arrow(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _osmdata_rcpp_osmdata_csv(SEXP, SEXP, SEXP);
+extern SEXP _osmdata_rcpp_osmdata_df(SEXP, SEXP, SEXP, SEXP);
+extern SEXP _osmdata_rcpp_osmdata_sc(SEXP, SEXP, SEXP);
+extern SEXP _osmdata_rcpp_osmdata_sf(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP _osmdata_rcpp_osmdata_sp(SEXP);
+extern SEXP _osmdata_rcpp_sc_c(SEXP, SEXP);
+extern SEXP _osmdata_rcpp_sc_contract(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _osmdata_rcpp_sc_elevation(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _osmdata_rcpp_sc_trim(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_osmdata_rcpp_osmdata_df", (DL_FUNC) &_osmdata_rcpp_osmdata_df, 1},
-    {"_osmdata_rcpp_osmdata_sc", (DL_FUNC) &_osmdata_rcpp_osmdata_sc, 1},
-    {"_osmdata_rcpp_osmdata_sf", (DL_FUNC) &_osmdata_rcpp_osmdata_sf, 1},
+    {"_osmdata_rcpp_osm_graph", (DL_FUNC) &_osmdata_rcpp_osm_graph, 6},
+    {"_osmdata_rcpp_osmdata_adiff", (DL_FUNC) &_osmdata_rcpp_osmdata_adiff, 2},
+    {"_osmdata_rcpp_osmdata_arrow", (DL_FUNC) &_osmdata_rcpp_osmdata_arrow, 7},
+    {"_osmdata_rcpp_osmdata_csv", (DL_FUNC) &_osmdata_rcpp_osmdata_csv, 3},
+    {"_osmdata_rcpp_osmdata_df", (DL_FUNC) &_osmdata_rcpp_osmdata_df, 4},
+    {"_osmdata_rcpp_osmdata_sc", (DL_FUNC) &_osmdata_rcpp_osmdata_sc, 3},
+    {"_osmdata_rcpp_osmdata_sf", (DL_FUNC) &_osmdata_rcpp_osmdata_sf, 9},
     {"_osmdata_rcpp_osmdata_sp", (DL_FUNC) &_osmdata_rcpp_osmdata_sp, 1},
+    {"_osmdata_rcpp_sc_c", (DL_FUNC) &_osmdata_rcpp_sc_c, 2},
+    {"_osmdata_rcpp_sc_contract", (DL_FUNC) &_osmdata_rcpp_sc_contract, 5},
+    {"_osmdata_rcpp_sc_elevation", (DL_FUNC) &_osmdata_rcpp_sc_elevation, 5},
+    {"_osmdata_rcpp_sc_trim", (DL_FUNC) &_osmdata_rcpp_sc_trim, 7},
     {NULL, NULL, 0}
 };
 
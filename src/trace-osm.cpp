@@ -31,6 +31,9 @@
 
 #include "trace-osm.h"
 
+#include <deque>
+#include <unordered_map>
+
 /* Traces a single relation of any type (SC only)
  *
  * @param itr_rel iterator to XmlData::Relations structure
@@ -220,6 +223,124 @@ void trace_multilinestring (Relations::const_iterator &itr_rel,
 }
 
 
+/* Traces a single multilinestring relation, merging contiguous member ways
+ *
+ * Alternative to 'trace_multilinestring' which joins all member ways of the
+ * given role into the longest possible linestrings, rather than returning one
+ * linestring for each way. End nodes of all member ways are first stored in
+ * an index, and ways are only joined at nodes which are the end of exactly two
+ * member ways. Merging thus never crosses junctions, and is independent of the
+ * order of ways within the relation. IDs of merged linestrings are the IDs of
+ * all component ways pasted together with "-", as for multipolygons.
+ *
+ * @param itr_rel iterator to XmlData::Relations structure
+ * @param role trace ways only matching this role in the relation
+ * @param &ways pointer to Ways structure
+ * @param &nodes pointer to Nodes structure
+ * @param &lon_vec pointer to 2D array of longitudes
+ * @param &lat_vec pointer to 2D array of latitudes
+ * @param &rowname_vec pointer to 2D array of rownames for each node.
+ * @param &ids pointer to vector of IDs of each merged linestring
+ */
+void trace_multilinestring_merged (Relations::const_iterator &itr_rel,
+        const std::string role, const Ways &ways, const Nodes &nodes,
+        double_arr2 &lon_vec, double_arr2 &lat_vec, string_arr2 &rowname_vec,
+        std::vector <std::string> &ids)
+{
+    // Ways which do not exist in the data set are skipped, as for
+    // 'trace_multilinestring'.
+    std::vector <Ways::const_iterator> rel_ways;
+    for (auto itw = itr_rel->ways.begin (); itw != itr_rel->ways.end (); ++itw)
+    {
+        if (itw->second != role)
+            continue;
+        auto wayi = ways.find (itw->first);
+        if (wayi != ways.end () && wayi->second.nodes.size () > 0)
+            rel_ways.push_back (wayi);
+    }
+    const size_t n = rel_ways.size ();
+
+    // Index of member ways terminating at each end node
+    std::unordered_map <osmid_t, std::vector <size_t> > end_index;
+    for (size_t i = 0; i < n; i++)
+    {
+        end_index [rel_ways [i]->second.nodes.front ()].push_back (i);
+        end_index [rel_ways [i]->second.nodes.back ()].push_back (i);
+    }
+
+    std::vector <bool> used (n, false);
+    // Returns the index of the one other unused way ending at 'node', or 'n' if
+    // there is none, or if 'node' is a junction of more than two ways.
+    auto next_way = [&] (const osmid_t node) -> size_t
+    {
+        auto e = end_index.find (node);
+        if (e->second.size () != 2)
+            return n;
+        for (auto j: e->second)
+            if (!used [j])
+                return j;
+        return n;
+    };
+    auto other_end = [&] (const size_t i, const osmid_t node) -> osmid_t
+    {
+        const std::vector <osmid_t> &nds = rel_ways [i]->second.nodes;
+        return (nds.front () == node) ? nds.back () : nds.front ();
+    };
+
+    std::vector <double> lons, lats;
+    std::vector <std::string> rownames;
+    std::stringstream this_way;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (used [i])
+            continue;
+        used [i] = true;
+
+        std::deque <size_t> chain;
+        chain.push_back (i);
+        osmid_t head = rel_ways [i]->second.nodes.front (),
+                tail = rel_ways [i]->second.nodes.back ();
+
+        size_t j;
+        while (tail != head && (j = next_way (tail)) < n)
+        {
+            used [j] = true;
+            chain.push_back (j);
+            tail = other_end (j, tail);
+        }
+        while (tail != head && (j = next_way (head)) < n)
+        {
+            used [j] = true;
+            chain.push_front (j);
+            head = other_end (j, head);
+        }
+
+        this_way.str ("");
+        osmid_t first_node = head;
+        bool append = false;
+        for (auto c: chain)
+        {
+            first_node = trace_way (ways, nodes, first_node,
+                    rel_ways [c]->first, lons, lats, rownames, append);
+            if (append)
+                this_way << "-";
+            this_way << std::to_string (rel_ways [c]->first);
+            append = true;
+        }
+
+        lon_vec.push_back (lons);
+        lat_vec.push_back (lats);
+        rowname_vec.push_back (rownames);
+        ids.push_back (this_way.str ());
+
+        lons.clear ();
+        lats.clear ();
+        rownames.clear ();
+    }
+}
+
+
 /* trace_way
  *
  * Traces a single way and adds (lon,lat,rownames) to corresponding vectors.
@@ -46,6 +46,11 @@ void trace_multilinestring (Relations::const_iterator &itr_rel,
         double_arr2 &lon_vec, double_arr2 &lat_vec, string_arr2 &rowname_vec,
         std::vector <osmid_t> &ids);
 
+void trace_multilinestring_merged (Relations::const_iterator &itr_rel,
+        const std::string role, const Ways &ways, const Nodes &nodes,
+        double_arr2 &lon_vec, double_arr2 &lat_vec, string_arr2 &rowname_vec,
+        std::vector <std::string> &ids);
+
 osmid_t trace_way (const Ways &ways, const Nodes &nodes, osmid_t first_node,
         const osmid_t &wayi_id, std::vector <double> &lons, 
         std::vector <double> &lats, std::vector <std::string> &rownames,